@@ -0,0 +1,279 @@
+// Microbenchmarks for the hot, GTK-free parts of gBar. Built with -DWithBench=true, run with ./gbar-bench
+#include "ProcParse.h"
+#include "HyprlandReply.h"
+#include "PeakMeter.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Keeps the compiler from dropping the benchmarked calls
+static volatile double sink;
+
+template<typename Fn>
+static void Bench(const char* name, uint64_t iterations, Fn&& fn)
+{
+    // Warm up caches and branch predictors
+    for (uint64_t i = 0; i < iterations / 10; i++)
+    {
+        sink = fn();
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        sink = fn();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    printf("%-32s %10.1f ns/op\n", name, elapsed.count() / iterations);
+}
+
+static std::string ReadFile(const char* path)
+{
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+// Parses the live /proc files of this machine, so the core count and layout are realistic
+static void BenchProcParsers()
+{
+    std::string stat = ReadFile("/proc/stat");
+    std::string meminfo = ReadFile("/proc/meminfo");
+    if (stat.empty() || meminfo.empty())
+    {
+        printf("Skipping /proc parsers: /proc is not readable\n");
+        return;
+    }
+    // What ReadProcStat(false) reads
+    std::string_view statFirstLine = std::string_view(stat).substr(0, 512);
+
+    Bench("ProcParse::ParseCPU", 1000000,
+          [&]()
+          {
+              ProcParse::CPUTimestamp timestamp;
+              ProcParse::ParseCPU(statFirstLine, timestamp);
+              return (double)timestamp.Total();
+          });
+
+    uint32_t numCores = 0;
+    for (size_t pos = stat.find("\ncpu"); pos != std::string::npos; pos = stat.find("\ncpu", pos + 1))
+    {
+        numCores++;
+    }
+    std::vector<uint64_t> total(numCores), idle(numCores);
+    Bench("ProcParse::ParseCPUCores", 100000,
+          [&]()
+          {
+              ProcParse::ParseCPUCores(stat, numCores, total.data(), idle.data());
+              return (double)total[0];
+          });
+
+    Bench("ProcParse::ParseMemInfo", 1000000,
+          [&]()
+          {
+              return ProcParse::ParseMemInfo(meminfo).totalGiB;
+          });
+}
+
+// Reply of "[[BATCH]]j/workspaces;j/monitors" in Hyprland's format, for two monitors and eight workspaces. Hyprland sends the two
+// arrays directly after each other.
+static constexpr std::string_view hyprlandReply = R"json([{
+    "id": 1,
+    "name": "1",
+    "monitor": "DP-1",
+    "monitorID": 0,
+    "windows": 3,
+    "hasfullscreen": false,
+    "lastwindow": "0x55d1c8a01001",
+    "lastwindowtitle": "nvim Bar.cpp"
+},{
+    "id": 2,
+    "name": "2",
+    "monitor": "DP-1",
+    "monitorID": 0,
+    "windows": 1,
+    "hasfullscreen": false,
+    "lastwindow": "0x55d1c8a02002",
+    "lastwindowtitle": "Mozilla Firefox"
+},{
+    "id": 3,
+    "name": "3",
+    "monitor": "DP-1",
+    "monitorID": 0,
+    "windows": 2,
+    "hasfullscreen": false,
+    "lastwindow": "0x55d1c8a03003",
+    "lastwindowtitle": "htop"
+},{
+    "id": 4,
+    "name": "4",
+    "monitor": "DP-1",
+    "monitorID": 0,
+    "windows": 1,
+    "hasfullscreen": false,
+    "lastwindow": "0x55d1c8a04004",
+    "lastwindowtitle": "Discord"
+},{
+    "id": 5,
+    "name": "5",
+    "monitor": "HDMI-A-1",
+    "monitorID": 1,
+    "windows": 2,
+    "hasfullscreen": false,
+    "lastwindow": "0x55d1c8a05005",
+    "lastwindowtitle": "mpv - \"Trailer\".mkv"
+},{
+    "id": 6,
+    "name": "6",
+    "monitor": "HDMI-A-1",
+    "monitorID": 1,
+    "windows": 1,
+    "hasfullscreen": false,
+    "lastwindow": "0x55d1c8a06006",
+    "lastwindowtitle": "Spotify"
+},{
+    "id": 7,
+    "name": "7",
+    "monitor": "HDMI-A-1",
+    "monitorID": 1,
+    "windows": 4,
+    "hasfullscreen": false,
+    "lastwindow": "0x55d1c8a07007",
+    "lastwindowtitle": "kitty"
+},{
+    "id": 8,
+    "name": "8",
+    "monitor": "HDMI-A-1",
+    "monitorID": 1,
+    "windows": 0,
+    "hasfullscreen": false,
+    "lastwindow": "0x0",
+    "lastwindowtitle": ""
+}][{
+    "id": 0,
+    "name": "DP-1",
+    "description": "Dell Inc. DELL S2721DGF 4X1VR83",
+    "make": "Dell Inc.",
+    "model": "DELL S2721DGF",
+    "serial": "",
+    "width": 2560,
+    "height": 1440,
+    "refreshRate": 143.99800,
+    "x": 0,
+    "y": 0,
+    "activeWorkspace": {
+        "id": 1,
+        "name": "1"
+    },
+    "specialWorkspace": {
+        "id": 0,
+        "name": ""
+    },
+    "reserved": [0, 32, 0, 0],
+    "scale": 1.00,
+    "transform": 0,
+    "focused": true,
+    "dpmsStatus": true,
+    "vrr": false,
+    "activelyTearing": false
+},{
+    "id": 1,
+    "name": "HDMI-A-1",
+    "description": "LG Electronics LG FULL HD 0x01010101",
+    "make": "LG Electronics",
+    "model": "LG FULL HD",
+    "serial": "",
+    "width": 1920,
+    "height": 1080,
+    "refreshRate": 60.00000,
+    "x": 2560,
+    "y": 0,
+    "activeWorkspace": {
+        "id": 6,
+        "name": "6"
+    },
+    "specialWorkspace": {
+        "id": 0,
+        "name": ""
+    },
+    "reserved": [0, 32, 0, 0],
+    "scale": 1.00,
+    "transform": 0,
+    "focused": false,
+    "dpmsStatus": true,
+    "vrr": false,
+    "activelyTearing": false
+}])json";
+
+static void BenchHyprlandReply()
+{
+    HyprlandReply::Model model;
+    if (!HyprlandReply::ParseJSON(hyprlandReply, model) || model.workspaceMonitors.size() != 8 || model.activeWorkspaces["HDMI-A-1"] != 6 ||
+        model.focusedMonitor != "DP-1")
+    {
+        printf("Skipping HyprlandReply::ParseJSON: The recorded reply was parsed incorrectly\n");
+        return;
+    }
+
+    // Resync builds a fresh model every time
+    Bench("HyprlandReply::ParseJSON", 100000,
+          []()
+          {
+              HyprlandReply::Model model;
+              HyprlandReply::ParseJSON(hyprlandReply, model);
+              return (double)model.workspaceMonitors.size();
+          });
+}
+
+// 100ms of interleaved stereo at 48kHz: A decaying 440Hz tone with a little noise, so the peak moves around
+static void BenchMaxAbs()
+{
+    constexpr size_t count = 2 * 4800;
+    std::vector<float> samples(count);
+    uint32_t noise = 1;
+    for (size_t i = 0; i < count; i++)
+    {
+        noise = noise * 1664525 + 1013904223;
+        float t = (float)(i / 2) / 48000.f;
+        samples[i] = 0.8f * std::exp(-10.f * t) * std::sin(2.f * (float)M_PI * 440.f * t) + ((float)(noise >> 8) / (1 << 24) - 0.5f) * 0.01f;
+    }
+
+    auto scalarMaxAbs = [&]()
+    {
+        float peak = 0.f;
+        for (float sample : samples)
+        {
+            peak = std::max(peak, std::fabs(sample));
+        }
+        return peak;
+    };
+    if (PeakMeter::MaxAbs(samples.data(), count) != scalarMaxAbs())
+    {
+        printf("Skipping PeakMeter::MaxAbs: Result differs from the scalar loop\n");
+        return;
+    }
+
+    Bench("PeakMeter::MaxAbs (9600 samples)", 100000,
+          [&]()
+          {
+              return (double)PeakMeter::MaxAbs(samples.data(), count);
+          });
+    Bench("Scalar loop (9600 samples)", 100000,
+          [&]()
+          {
+              return (double)scalarMaxAbs();
+          });
+}
+
+int main()
+{
+    BenchProcParsers();
+    BenchHyprlandReply();
+    BenchMaxAbs();
+    return 0;
+}
@@ -0,0 +1,115 @@
+'''Mock BlueZ, to try the bluetooth widget without hardware
+
+This script is not used by gBar. It is a python-dbusmock template (pip install python-dbusmock) with one adapter and four devices:
+  AA:BB:CC:DD:EE:01 "Mock Headset"   Pair and Connect succeed, so connecting runs Pair -> Connect
+  AA:BB:CC:DD:EE:02 "Slow Keyboard"  Pair only replies after PAIR_DELAY seconds, unless CancelPairing is called in between
+  AA:BB:CC:DD:EE:03 "Broken Mouse"   Pair fails with org.bluez.Error.AuthenticationFailed
+  AA:BB:CC:DD:EE:04 "Mock Speaker"   Only gets an RSSI, once discovery is started
+
+Run the mock on a private bus, so the real bluetoothd is never touched. gBar takes the system bus from DBUS_SYSTEM_BUS_ADDRESS:
+  export DBUS_SYSTEM_BUS_ADDRESS="$(dbus-daemon --session --fork --print-address)"
+  python3 -m dbusmock --template data/mock_bluez.py -l /tmp/mock_bluez.log &
+  gBar bluetooth
+
+Pair -> Connect: Click "Mock Headset". The mock log shows Pair, then Connect, and the row turns active.
+Error reply:     Click "Broken Mouse". gBar logs
+                 "Bluetooth: Failed to connect AA:BB:CC:DD:EE:03: org.bluez.Error.AuthenticationFailed: Authentication Failed"
+                 and the row gets the "failed" class.
+Cancellation:    Click "Slow Keyboard" and close the popup within PAIR_DELAY seconds. The popup closes right away, gBar logs no result
+                 for the request and the mock log shows Pair, then CancelPairing, without a Connect. The Keyboard stays unpaired.
+RSSI:            Start scanning in the popup (StartDiscovery), then change the signal strength with
+                   gdbus call -a "$DBUS_SYSTEM_BUS_ADDRESS" -d org.bluez -o / -m org.bluez.Mock.SetRSSI "'AA:BB:CC:DD:EE:04'" -- -40
+                 Changes below 5 dB are ignored by gBar.
+'''
+
+import dbus
+
+from dbusmock import mockobject
+
+BUS_NAME = 'org.bluez'
+MAIN_OBJ = '/'
+SYSTEM_BUS = True
+IS_OBJECT_MANAGER = True
+
+MOCK_IFACE = 'org.bluez.Mock'
+ADAPTER_IFACE = 'org.bluez.Adapter1'
+DEVICE_IFACE = 'org.bluez.Device1'
+
+ADAPTER_PATH = '/org/bluez/hci0'
+PAIR_DELAY = 10
+
+
+def DevicePath(address):
+    return ADAPTER_PATH + '/dev_' + address.replace(':', '_')
+
+
+def UpdateDevice(properties):
+    return "self.UpdateProperties('%s', %s)" % (DEVICE_IFACE, properties)
+
+
+PAIR = UpdateDevice("{'Paired': True}")
+# Keeps the main loop running while waiting, so CancelPairing is handled during the pending Pair call like in BlueZ
+SLOW_PAIR = '''import time
+from gi.repository import GLib
+self.pairing_cancelled = False
+deadline = time.time() + %d
+while time.time() < deadline and not self.pairing_cancelled:
+    GLib.MainContext.default().iteration(False)
+    time.sleep(0.05)
+if self.pairing_cancelled:
+    raise dbus.exceptions.DBusException('Authentication Canceled', name='org.bluez.Error.AuthenticationCanceled')
+''' % PAIR_DELAY + PAIR
+CANCEL_PAIRING = "self.pairing_cancelled = True"
+FAILING_PAIR = "raise dbus.exceptions.DBusException('Authentication Failed', name='org.bluez.Error.AuthenticationFailed')"
+CONNECT = UpdateDevice("{'Connected': True}")
+DISCONNECT = UpdateDevice("{'Connected': False}")
+
+# Address, name, icon, Pair
+DEVICES = [
+    ('AA:BB:CC:DD:EE:01', 'Mock Headset', 'audio-headset', PAIR),
+    ('AA:BB:CC:DD:EE:02', 'Slow Keyboard', 'input-keyboard', SLOW_PAIR),
+    ('AA:BB:CC:DD:EE:03', 'Broken Mouse', 'input-mouse', FAILING_PAIR),
+    ('AA:BB:CC:DD:EE:04', 'Mock Speaker', 'audio-card', PAIR),
+]
+DISCOVERED_DEVICE = 'AA:BB:CC:DD:EE:04'
+
+
+def load(mock, parameters):
+    start_discovery = ("self.UpdateProperties('%s', {'Discovering': True})\n" % ADAPTER_IFACE +
+                       "mockobject.objects['%s'].UpdateProperties('%s', {'RSSI': dbus.Int16(-70)})"
+                       % (DevicePath(DISCOVERED_DEVICE), DEVICE_IFACE))
+    mock.AddObject(ADAPTER_PATH, ADAPTER_IFACE,
+                   {
+                       'Address': dbus.String('00:11:22:33:44:55'),
+                       'Name': dbus.String('gBar mock adapter'),
+                       'Powered': dbus.Boolean(True),
+                       'Discovering': dbus.Boolean(False),
+                   },
+                   [
+                       ('StartDiscovery', '', '', 'from dbusmock import mockobject\n' + start_discovery),
+                       ('StopDiscovery', '', '', "self.UpdateProperties('%s', {'Discovering': False})" % ADAPTER_IFACE),
+                   ])
+
+    for address, name, icon, pair in DEVICES:
+        mock.AddObject(DevicePath(address), DEVICE_IFACE,
+                       {
+                           'Address': dbus.String(address),
+                           'Name': dbus.String(name),
+                           'Alias': dbus.String(name),
+                           'Icon': dbus.String(icon),
+                           'Adapter': dbus.ObjectPath(ADAPTER_PATH),
+                           'Paired': dbus.Boolean(False),
+                           'Connected': dbus.Boolean(False),
+                       },
+                       [
+                           ('Pair', '', '', pair),
+                           ('CancelPairing', '', '', CANCEL_PAIRING),
+                           ('Connect', '', '', CONNECT),
+                           ('Disconnect', '', '', DISCONNECT),
+                       ])
+
+
+@dbus.service.method(MOCK_IFACE, in_signature='sn', out_signature='')
+def SetRSSI(self, address, rssi):
+    '''Changes the signal strength of a device, like BlueZ does while discovering'''
+    mockobject.objects[DevicePath(address)].UpdateProperties(DEVICE_IFACE, {'RSSI': dbus.Int16(rssi)})
@@ -1,5 +1,6 @@
 #include "Common.h"
 #include "Config.h"
+#include "SensorFile.h"
 
 #include <fstream>
 
@@ -30,10 +31,14 @@ namespace AMDGPU
             return {};
         }
 
-        std::ifstream file(drmCardPrefix + Config::Get().drmAmdCard + utilizationFile);
-        std::string line;
-        std::getline(file, line);
-        return atoi(line.c_str());
+        static SensorFile file;
+        if (!file.IsConfigured())
+        {
+            file.Open(drmCardPrefix + Config::Get().drmAmdCard + utilizationFile);
+        }
+        uint64_t utilization = 0;
+        file.ReadUInt(utilization);
+        return utilization;
     }
 
     inline uint32_t GetTemperature()
@@ -44,11 +49,14 @@ namespace AMDGPU
             return {};
         }
 
-        std::ifstream file(drmCardPrefix + Config::Get().drmAmdCard + Config::Get().amdGpuThermalZone);
-
-        std::string line;
-        std::getline(file, line);
-        return atoi(line.c_str()) / 1000;
+        static SensorFile file;
+        if (!file.IsConfigured())
+        {
+            file.Open(drmCardPrefix + Config::Get().drmAmdCard + Config::Get().amdGpuThermalZone);
+        }
+        uint64_t temp = 0;
+        file.ReadUInt(temp);
+        return temp / 1000;
     }
 
     struct VRAM
@@ -66,14 +74,15 @@ namespace AMDGPU
         }
         VRAM mem{};
 
-        std::ifstream file(drmCardPrefix + Config::Get().drmAmdCard + vramTotalFile);
-        std::string line;
-        std::getline(file, line);
-        mem.totalB = strtoul(line.c_str(), nullptr, 10);
-
-        file = std::ifstream(drmCardPrefix + Config::Get().drmAmdCard + vramUsedFile);
-        std::getline(file, line);
-        mem.usedB = strtoul(line.c_str(), nullptr, 10);
+        static SensorFile totalFile;
+        static SensorFile usedFile;
+        if (!totalFile.IsConfigured())
+        {
+            totalFile.Open(drmCardPrefix + Config::Get().drmAmdCard + vramTotalFile);
+            usedFile.Open(drmCardPrefix + Config::Get().drmAmdCard + vramUsedFile);
+        }
+        totalFile.ReadUInt(mem.totalB);
+        usedFile.ReadUInt(mem.usedB);
 
         return mem;
     }
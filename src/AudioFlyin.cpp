@@ -1,6 +1,8 @@
 #include "AudioFlyin.h"
 #include "System.h"
 
+#include <algorithm>
+
 namespace AudioFlyin
 {
     namespace DynCtx
@@ -10,14 +12,22 @@ namespace AudioFlyin
         Window* win;
         Slider* slider;
         Text* icon;
-        double sliderVal;
+        LevelMeter* meter;
+        double sliderVal = -1;
         bool muted = false;
 
-        int32_t msOpen = 0;
-        constexpr int32_t closeTime = 2000;
+        GtkWidget* mainWidget = nullptr;
+        // All times are monotonic, in microseconds
+        constexpr int64_t closeTime = 2000 * 1000;
         constexpr int32_t height = 50;
-        int32_t curCloseTime = closeTime;
-        int32_t transitionTime = 50;
+        constexpr int64_t transitionTime = 50 * 1000;
+        int64_t openedAt = 0;
+        int64_t closeAt = 0;
+
+        // Frame clock callback of the manual animation. Only installed, while the flyin is moving.
+        guint tickId = 0;
+        // Wakes us up for the fly out (Or the close, without manual animation)
+        guint wakeupSource = 0;
 
         void OnChangeVolume(Slider&, double value)
         {
@@ -31,71 +41,108 @@ namespace AudioFlyin
             }
         }
 
-        TimerResult Main(Box&)
+        void OnLevel(const System::AudioLevel& level)
         {
-            System::AudioInfo info = System::GetAudioInfo();
-            if (type == Type::Speaker)
+            meter->SetLevel(type == Type::Speaker ? level.sink : level.source);
+        }
+
+        int32_t Margin(int64_t now)
+        {
+            // A inverted, cutoff 'V' shape
+            // Fly in -> hover -> fly out
+            double in = (double)(now - openedAt) / transitionTime;
+            double out = (double)(closeAt - now) / transitionTime;
+            return (int32_t)(std::clamp(std::min(in, out), 0., 1.) * height);
+        }
+
+        void ScheduleWakeup();
+
+        gboolean OnTick(GtkWidget*, GdkFrameClock* clock, gpointer)
+        {
+            int64_t now = gdk_frame_clock_get_frame_time(clock);
+            if (now >= closeAt)
             {
-                if (sliderVal != info.sinkVolume || muted != info.sinkMuted)
-                {
-                    // Extend timer
-                    curCloseTime = msOpen + closeTime;
-
-                    sliderVal = info.sinkVolume;
-                    slider->SetValue(info.sinkVolume);
-
-                    muted = info.sinkMuted;
-                    if (info.sinkMuted)
-                    {
-                        icon->SetText(Config::Get().speakerMutedIcon);
-                    }
-                    else
-                    {
-                        icon->SetText(Config::Get().speakerHighIcon);
-                    }
-                }
+                tickId = 0;
+                win->Close();
+                return G_SOURCE_REMOVE;
             }
-            else if (type == Type::Microphone)
+
+            int32_t margin = Margin(now);
+            win->SetMargin(Anchor::Bottom, margin);
+            if (margin == height)
             {
-                if (sliderVal != info.sourceVolume || muted != info.sourceMuted)
-                {
-                    // Extend timer
-                    curCloseTime = msOpen + closeTime;
-
-                    sliderVal = info.sourceVolume;
-                    slider->SetValue(info.sourceVolume);
-
-                    muted = info.sourceMuted;
-                    if (info.sourceMuted)
-                    {
-                        icon->SetText(Config::Get().micMutedIcon);
-                    }
-                    else
-                    {
-                        icon->SetText(Config::Get().micHighIcon);
-                    }
-                }
+                // Fully flown in, nothing moves until the fly out
+                tickId = 0;
+                ScheduleWakeup();
+                return G_SOURCE_REMOVE;
             }
+            return G_SOURCE_CONTINUE;
+        }
 
-            msOpen++;
+        void StartTicking()
+        {
+            if (tickId == 0 && mainWidget)
+            {
+                tickId = gtk_widget_add_tick_callback(mainWidget, OnTick, nullptr, nullptr);
+            }
+        }
 
+        gboolean OnWakeup(gpointer)
+        {
+            wakeupSource = 0;
             if (Config::Get().manualFlyinAnimation)
             {
-                auto marginFunction = [](int32_t x) -> int32_t
-                {
-                    // A inverted, cutoff 'V' shape
-                    // Fly in -> hover -> fly out
-                    double steepness = (double)height / (double)transitionTime;
-                    return (int32_t)std::min(-std::abs((double)x - (double)curCloseTime / 2) * steepness + (double)curCloseTime / 2, (double)height);
-                };
-                win->SetMargin(Anchor::Bottom, marginFunction(msOpen));
+                StartTicking();
             }
-
-            if (msOpen >= curCloseTime)
+            else if (g_get_monotonic_time() >= closeAt)
             {
                 win->Close();
             }
-            return TimerResult::Ok;
+            else
+            {
+                ScheduleWakeup();
+            }
+            return G_SOURCE_REMOVE;
+        }
+
+        void ScheduleWakeup()
+        {
+            if (tickId != 0)
+            {
+                // The tick callback picks up the new close time itself
+                return;
+            }
+            if (wakeupSource != 0)
+            {
+                g_source_remove(wakeupSource);
+            }
+            int64_t wakeupAt = Config::Get().manualFlyinAnimation ? closeAt - transitionTime : closeAt;
+            int64_t delay = std::max<int64_t>(wakeupAt - g_get_monotonic_time(), 0);
+            wakeupSource = g_timeout_add((guint)((delay + 999) / 1000), OnWakeup, nullptr);
+        }
+
+        void OnAudioChange(const System::AudioInfo& info)
+        {
+            double volume = type == Type::Speaker ? info.sinkVolume : info.sourceVolume;
+            bool isMuted = type == Type::Speaker ? info.sinkMuted : info.sourceMuted;
+            if (volume == sliderVal && isMuted == muted)
+                return;
+
+            sliderVal = volume;
+            slider->SetValue(volume);
+            muted = isMuted;
+            if (type == Type::Speaker)
+            {
+                icon->SetText(muted ? Config::Get().speakerMutedIcon : Config::Get().speakerHighIcon);
+            }
+            else
+            {
+                icon->SetText(muted ? Config::Get().micMutedIcon : Config::Get().micHighIcon);
+            }
+
+            // Extend timer
+            closeAt = g_get_monotonic_time() + closeTime;
+            ScheduleWakeup();
         }
     }
     void WidgetAudio(Widget& parent)
@@ -132,6 +179,23 @@ namespace AudioFlyin
         DynCtx::icon = icon.get();
 
         parent.AddChild(std::move(slider));
+        if (Config::Get().audioLevelMeter)
+        {
+            auto meter = Widget::Create<LevelMeter>();
+            meter->SetOrientation(Orientation::Vertical);
+            meter->SetHorizontalTransform({4, false, Alignment::Fill});
+            meter->SetVerticalTransform({16, false, Alignment::Center});
+            meter->SetClass(DynCtx::type == Type::Speaker ? "audio-level" : "mic-level");
+            DynCtx::meter = meter.get();
+
+            uint32_t callbackId = System::AddAudioLevelCallback(DynCtx::OnLevel);
+            meter->AddOnDestroy(
+                [callbackId]()
+                {
+                    System::RemoveAudioLevelCallback(callbackId);
+                });
+            parent.AddChild(std::move(meter));
+        }
         parent.AddChild(std::move(icon));
     }
 
@@ -139,12 +203,29 @@ namespace AudioFlyin
     {
         DynCtx::win = &window;
         DynCtx::type = type;
+        // May be opened repeatedly by the bar
+        DynCtx::sliderVal = -1;
+        DynCtx::muted = false;
         auto mainWidget = Widget::Create<Box>();
         mainWidget->SetSpacing({8, false});
         mainWidget->SetVerticalTransform({16, true, Alignment::Fill});
         mainWidget->SetClass("bar");
-        // We update the margin in the timer, so we need late dispatch.
-        mainWidget->AddTimer<Box>(DynCtx::Main, 1, TimerDispatchBehaviour::LateDispatch);
+        DynCtx::openedAt = g_get_monotonic_time();
+        DynCtx::closeAt = DynCtx::openedAt + DynCtx::closeTime;
+        if (Config::Get().manualFlyinAnimation)
+        {
+            // The frame clock only exists once the widget is realized
+            mainWidget->SetOnCreate(
+                [](Widget& widget)
+                {
+                    DynCtx::mainWidget = widget.Get();
+                    DynCtx::StartTicking();
+                });
+        }
+        else
+        {
+            DynCtx::ScheduleWakeup();
+        }
 
         auto padding = Widget::Create<Box>();
         padding->SetHorizontalTransform({8, true, Alignment::Fill});
@@ -152,6 +233,23 @@ namespace AudioFlyin
 
         WidgetAudio(*mainWidget);
 
+        // Show the current state right away, the callback only fires on changes
+        DynCtx::OnAudioChange(System::GetAudioInfo());
+        uint32_t callbackId = System::AddAudioChangeCallback(DynCtx::OnAudioChange);
+        mainWidget->AddOnDestroy(
+            [callbackId]()
+            {
+                System::RemoveAudioChangeCallback(callbackId);
+                if (DynCtx::wakeupSource != 0)
+                {
+                    g_source_remove(DynCtx::wakeupSource);
+                    DynCtx::wakeupSource = 0;
+                }
+                // Removed by GTK together with the widget
+                DynCtx::tickId = 0;
+                DynCtx::mainWidget = nullptr;
+            });
+
         padding = Widget::Create<Box>();
         mainWidget->AddChild(std::move(padding));
 
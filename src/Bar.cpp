@@ -4,8 +4,12 @@
 #include "Common.h"
 #include "Config.h"
 #include "SNI.h"
-#include <mutex>
+#include "Popup.h"
+#include "Control.h"
+#include "Script.h"
+#include <algorithm>
 #include <cstdlib>
+#include <unordered_map>
 
 namespace Bar
 {
@@ -50,6 +54,22 @@ namespace Bar
         constexpr uint32_t updateTime = 1000;
         constexpr uint32_t updateTimeFast = 100;
 
+        // "gBar resample" redraws the sensor right away, instead of on its next timer tick
+        template<typename TWidget>
+        static void UpdateOnResample(TWidget& widget, TimerCallback<TWidget> update)
+        {
+            uint32_t id = System::AddSensorResampleCallback(
+                [&widget, update = std::move(update)]()
+                {
+                    update(widget);
+                });
+            widget.AddOnDestroy(
+                [id]()
+                {
+                    System::RemoveSensorResampleCallback(id);
+                });
+        }
+
         static Revealer* powerBoxRevealer;
         static void PowerBoxEvent(EventBox&, bool hovered)
         {
@@ -59,8 +79,11 @@ namespace Bar
         static Text* cpuText;
         static TimerResult UpdateCPU(Sensor& sensor)
         {
-            double usage = System::GetCPUUsage();
-            double temp = System::GetCPUTemp();
+            const System::SensorSnapshot& snapshot = System::GetSensorSnapshot();
+            if (!snapshot.Has(System::Sensor::CPU))
+                return TimerResult::Ok;
+            double usage = snapshot.cpu.usage;
+            double temp = snapshot.cpuTemp;
 
             std::string text = "CPU: " + Utils::ToStringPrecision(usage * 100, "%0.1f") + "% " + Utils::ToStringPrecision(temp, "%0.1f") + "°C";
             if (Config::Get().sensorTooltips)
@@ -75,11 +98,51 @@ namespace Bar
             return TimerResult::Ok;
         }
 
+        static Text* cpuCoresText;
+        static TimerResult UpdateCPUCores(SensorStrip& strip)
+        {
+            const System::SensorSnapshot& snapshot = System::GetSensorSnapshot();
+            if (!snapshot.Has(System::Sensor::CPUCores))
+                return TimerResult::Ok;
+            const System::CPUCoresInfo& cores = snapshot.cores;
+
+            float maxUsage = 0;
+            double sumUsage = 0;
+            double sumFrequency = 0;
+            for (size_t i = 0; i < cores.usage.size(); i++)
+            {
+                maxUsage = std::max(maxUsage, cores.usage[i]);
+                sumUsage += cores.usage[i];
+                sumFrequency += cores.frequencyMHz[i];
+            }
+            double numCores = cores.usage.size();
+
+            std::string text = "Cores: " + Utils::ToStringPrecision(sumUsage / numCores * 100, "%0.1f") + "% avg " +
+                               Utils::ToStringPrecision(maxUsage * 100, "%0.1f") + "% max";
+            if (sumFrequency > 0)
+            {
+                text += " " + Utils::ToStringPrecision(sumFrequency / numCores / 1000, "%0.2f") + "GHz";
+            }
+            if (Config::Get().sensorTooltips)
+            {
+                strip.SetTooltip(text);
+            }
+            else
+            {
+                cpuCoresText->SetText(text);
+            }
+            strip.SetValues(cores.usage);
+            return TimerResult::Ok;
+        }
+
         static Text* batteryText;
         static bool wasCharging = false;
         static TimerResult UpdateBattery(Sensor& sensor)
         {
-            double percentage = System::GetBatteryPercentage();
+            const System::SensorSnapshot& snapshot = System::GetSensorSnapshot();
+            if (!snapshot.Has(System::Sensor::Battery))
+                return TimerResult::Ok;
+            double percentage = snapshot.batteryPercentage;
 
             std::string text = "Battery: " + Utils::ToStringPrecision(percentage * 100, "%0.1f") + "%";
             if (Config::Get().sensorTooltips)
@@ -92,7 +155,7 @@ namespace Bar
             }
             sensor.SetValue(percentage);
 
-            bool isCharging = System::IsBatteryCharging();
+            bool isCharging = snapshot.batteryCharging;
             if (isCharging && !wasCharging && sensor.Get() != nullptr)
             {
                 sensor.AddClass("battery-charging");
@@ -127,7 +190,10 @@ namespace Bar
         static Text* ramText;
         static TimerResult UpdateRAM(Sensor& sensor)
         {
-            System::RAMInfo info = System::GetRAMInfo();
+            const System::SensorSnapshot& snapshot = System::GetSensorSnapshot();
+            if (!snapshot.Has(System::Sensor::RAM))
+                return TimerResult::Ok;
+            const System::RAMInfo& info = snapshot.ram;
             double used = info.totalGiB - info.freeGiB;
             double usedPercent = used / info.totalGiB;
 
@@ -148,7 +214,10 @@ namespace Bar
         static Text* gpuText;
         static TimerResult UpdateGPU(Sensor& sensor)
         {
-            System::GPUInfo info = System::GetGPUInfo();
+            const System::SensorSnapshot& snapshot = System::GetSensorSnapshot();
+            if (!snapshot.Has(System::Sensor::GPU))
+                return TimerResult::Ok;
+            const System::GPUInfo& info = snapshot.gpu;
 
             std::string text = "GPU: " + Utils::ToStringPrecision(info.utilisation, "%0.1f") + "% " +
                                Utils::ToStringPrecision(info.coreTemp, "%0.1f") + "°C";
@@ -167,7 +236,10 @@ namespace Bar
         static Text* vramText;
         static TimerResult UpdateVRAM(Sensor& sensor)
         {
-            System::VRAMInfo info = System::GetVRAMInfo();
+            const System::SensorSnapshot& snapshot = System::GetSensorSnapshot();
+            if (!snapshot.Has(System::Sensor::VRAM))
+                return TimerResult::Ok;
+            const System::VRAMInfo& info = snapshot.vram;
 
             std::string text = "VRAM: " + Utils::ToStringPrecision(info.usedGiB, "%0.2f") + "GiB/" +
                                Utils::ToStringPrecision(info.totalGiB, "%0.2f") + "GiB";
@@ -187,7 +259,10 @@ namespace Bar
         static Text* diskText;
         static TimerResult UpdateDisk(Sensor& sensor)
         {
-            System::DiskInfo info = System::GetDiskInfo();
+            const System::SensorSnapshot& snapshot = System::GetSensorSnapshot();
+            if (!snapshot.Has(System::Sensor::Disk))
+                return TimerResult::Ok;
+            const System::DiskInfo& info = snapshot.disk;
 
             std::string text = "Disk " + info.partition + ": " + Utils::ToStringPrecision(info.usedGiB, "%0.2f") + "GiB/" +
                                Utils::ToStringPrecision(info.totalGiB, "%0.2f") + "GiB";
@@ -206,9 +281,9 @@ namespace Bar
 #ifdef WITH_BLUEZ
         static Button* btIconText;
         static Text* btDevText;
-        static TimerResult UpdateBluetooth(Box&)
+        static void UpdateBluetooth()
         {
-            System::BluetoothInfo info = System::GetBluetoothInfo();
+            const System::BluetoothInfo& info = System::GetBluetoothInfo();
             if (info.defaultController.empty())
             {
                 btIconText->SetClass("bt-label-off");
@@ -232,8 +307,17 @@ namespace Bar
                     if (!dev.connected)
                         continue;
                     std::string ico = System::BTTypeToIcon(dev);
-                    tooltip += dev.name + " & ";
+                    tooltip += dev.name;
+                    if (dev.battery >= 0)
+                    {
+                        tooltip += " (" + std::to_string(dev.battery) + "%)";
+                    }
+                    tooltip += " & ";
                     btDev += ico;
+                    if (Config::Get().btBattery && dev.battery >= 0)
+                    {
+                        btDev += std::to_string(dev.battery) + "% ";
+                    }
 
                     if (RotatedIcons())
                     {
@@ -249,22 +333,19 @@ namespace Bar
                 btDevText->SetTooltip(tooltip);
                 btDevText->SetText(std::move(btDev));
             }
-            return TimerResult::Ok;
         }
 
         void OnBTClick(Button&)
         {
-            System::OpenBTWidget();
+            Popup::Open(Popup::Type::Bluetooth, monitor);
         }
 #endif
 
-        static std::mutex packageTextLock;
         static TimerResult UpdatePackages(Text& text)
         {
             System::GetOutdatedPackagesAsync(
                 [&](uint32_t numOutdatedPackages)
                 {
-                    packageTextLock.lock();
                     if (numOutdatedPackages)
                     {
                         text.SetText(Config::Get().packageOutOfDateIcon);
@@ -279,7 +360,6 @@ namespace Bar
                         text.SetClass("package-empty");
                         text.SetTooltip("");
                     }
-                    packageTextLock.unlock();
                 });
             return TimerResult::Ok;
         }
@@ -288,30 +368,18 @@ namespace Bar
         Widget* micSlider;
         Button* audioIcon;
         Button* micIcon;
+        LevelMeter* audioMeter = nullptr;
+        LevelMeter* micMeter = nullptr;
 
-        static AsyncAtomicContext<double> sinkAsyncContext;
+        // Setting the volume doesn't block and coalesces values, that are set while the last one is still in flight.
         void OnChangeVolumeSink(Slider&, double value)
         {
-            // Process async and atomically, so the event handler isn't filled up
-            ExecuteAsyncAtomically(
-                sinkAsyncContext,
-                [](double volume)
-                {
-                    System::SetVolumeSink(volume);
-                },
-                value);
+            System::SetVolumeSink(value);
         }
 
-        static AsyncAtomicContext<double> sourceAsyncContext;
         void OnChangeVolumeSource(Slider&, double value)
         {
-            ExecuteAsyncAtomically(
-                sourceAsyncContext,
-                [](double volume)
-                {
-                    System::SetVolumeSource(volume);
-                },
-                value);
+            System::SetVolumeSource(value);
         }
 
         // For text
@@ -320,14 +388,7 @@ namespace Bar
         {
             audioVolume += delta;
             audioVolume = std::clamp(audioVolume, 0.0, 1.0);
-            // Process async and atomically, so the event handler isn't filled up
-            ExecuteAsyncAtomically(
-                sinkAsyncContext,
-                [](double volume)
-                {
-                    System::SetVolumeSink(volume);
-                },
-                audioVolume);
+            System::SetVolumeSink(audioVolume);
         }
 
         double micVolume = 0;
@@ -335,14 +396,7 @@ namespace Bar
         {
             micVolume += delta;
             micVolume = std::clamp(micVolume, 0.0, 1.0);
-            // Process async and atomically, so the event handler isn't filled up
-            ExecuteAsyncAtomically(
-                sourceAsyncContext,
-                [](double volume)
-                {
-                    System::SetVolumeSource(volume);
-                },
-                micVolume);
+            System::SetVolumeSource(micVolume);
         }
 
         void OnToggleSink(Button& button)
@@ -357,9 +411,8 @@ namespace Bar
             System::SetMutedSource(!info.sourceMuted);
         }
 
-        TimerResult UpdateAudio(Widget&)
+        void UpdateAudio(const System::AudioInfo& info)
         {
-            System::AudioInfo info = System::GetAudioInfo();
             if (Config::Get().audioNumbers)
             {
                 audioVolume = info.sinkVolume;
@@ -397,14 +450,59 @@ namespace Bar
                     micIcon->SetText(Config::Get().micHighIcon);
                 }
             }
-            return TimerResult::Ok;
+        }
+
+        void UpdateAudioLevel(const System::AudioLevel& level)
+        {
+            if (audioMeter)
+                audioMeter->SetLevel(level.sink);
+            if (micMeter)
+                micMeter->SetLevel(level.source);
+        }
+
+        // Widgets, that are set through the control socket
+        std::unordered_map<std::string, Text*> namedTexts;
+        std::unordered_map<std::string, Sensor*> namedSensors;
+
+        // set-text <name> <text>
+        std::string SetNamedText(std::string_view args)
+        {
+            size_t nameEnd = args.find(' ');
+            std::string name = std::string(args.substr(0, nameEnd));
+            auto it = namedTexts.find(name);
+            if (it == namedTexts.end())
+                return "no text widget \"" + name + "\"";
+            it->second->SetText(nameEnd == std::string_view::npos ? "" : std::string(args.substr(nameEnd + 1)));
+            return "";
+        }
+
+        // set-value <name> <0-1>
+        std::string SetNamedValue(std::string_view args)
+        {
+            size_t nameEnd = args.find(' ');
+            std::string name = std::string(args.substr(0, nameEnd));
+            auto it = namedSensors.find(name);
+            if (it == namedSensors.end())
+                return "no sensor widget \"" + name + "\"";
+            if (nameEnd == std::string_view::npos)
+                return "missing value";
+            std::string valueStr = std::string(args.substr(nameEnd + 1));
+            char* end;
+            double value = strtod(valueStr.c_str(), &end);
+            if (end == valueStr.c_str() || *end != '\0')
+                return "invalid value \"" + valueStr + "\"";
+            it->second->SetValue(std::clamp(value, 0., 1.));
+            return "";
         }
 
         Text* networkText;
         TimerResult UpdateNetwork(NetworkSensor& sensor)
         {
-            double bpsUp = System::GetNetworkBpsUpload(updateTime / 1000.0);
-            double bpsDown = System::GetNetworkBpsDownload(updateTime / 1000.0);
+            const System::SensorSnapshot& snapshot = System::GetSensorSnapshot();
+            if (!snapshot.Has(System::Sensor::Network))
+                return TimerResult::Ok;
+            double bpsUp = snapshot.networkUpBps;
+            double bpsDown = snapshot.networkDownBps;
 
             std::string upload = Utils::StorageUnitDynamic(bpsUp, "%0.1f%s");
             std::string download = Utils::StorageUnitDynamic(bpsDown, "%0.1f%s");
@@ -431,9 +529,9 @@ namespace Bar
             return TimerResult::Ok;
         }
 
-        TimerResult UpdateTitle(Text& text)
+        void UpdateTitle(Text& text)
         {
-            std::string title = System::GetActiveWindowTitle();
+            std::string title = System::GetFocusedWindowTitle(monitor);
             if (title.size() > Config::Get().maxTitleLength)
             {
                 constexpr std::string_view ellipsis = "...";
@@ -441,8 +539,8 @@ namespace Bar
                 title.resize(newLength);
                 title += ellipsis;
             }
+            // Doesn't touch the label, if the title didn't change
             text.SetText(title);
-            return TimerResult::Ok;
         }
 
 #ifdef WITH_WORKSPACES
@@ -494,8 +592,11 @@ namespace Bar
 #endif
     }
 
-    void WidgetSensor(Widget& parent, TimerCallback<Sensor>&& callback, const std::string& sensorName, Text*& textPtr, Side side)
+    void WidgetSensor(Widget& parent, System::Sensor sensorType, TimerCallback<Sensor>&& callback, const std::string& sensorName, Text*& textPtr,
+                      Side side)
     {
+        System::EnableSensor(sensorType);
+
         auto eventBox = Widget::Create<EventBox>();
         Utils::SetTransform(*eventBox, {-1, false, SideToAlignment(side)});
         {
@@ -544,6 +645,7 @@ namespace Bar
                 sensor->SetStyle({angle});
                 auto sensorClass = sensorName + "-util-progress";
                 sensor->SetClass(sensorClass);
+                DynCtx::UpdateOnResample<Sensor>(*sensor, callback);
                 sensor->AddTimer<Sensor>(std::move(callback), DynCtx::updateTime);
                 Utils::SetTransform(*sensor, {(int)Config::Get().sensorSize, true, Alignment::Fill});
 
@@ -697,6 +799,26 @@ namespace Bar
                     widgetAudioVolume(*box, type);
                 }
 
+                if (Config::Get().audioLevelMeter)
+                {
+                    // Thin bar across the bar, so it doesn't take away space from the slider
+                    auto meter = Widget::Create<LevelMeter>();
+                    meter->SetOrientation(Utils::GetOrientation() == Orientation::Horizontal ? Orientation::Vertical : Orientation::Horizontal);
+                    Utils::SetTransform(*meter, {4, false, Alignment::Fill}, {16, false, Alignment::Center});
+                    switch (type)
+                    {
+                    case AudioType::Input:
+                        meter->SetClass("mic-level");
+                        DynCtx::micMeter = meter.get();
+                        break;
+                    case AudioType::Output:
+                        meter->SetClass("audio-level");
+                        DynCtx::audioMeter = meter.get();
+                        break;
+                    }
+                    box->AddChild(std::move(meter));
+                }
+
                 box->AddChild(std::move(icon));
             }
             parent.AddChild(std::move(box));
@@ -725,7 +847,24 @@ namespace Bar
             }
             widgetAudioBody(parent, AudioType::Output);
         }
-        parent.AddTimer<Widget>(DynCtx::UpdateAudio, DynCtx::updateTimeFast);
+        DynCtx::UpdateAudio(System::GetAudioInfo());
+        uint32_t callbackId = System::AddAudioChangeCallback(DynCtx::UpdateAudio);
+        parent.AddOnDestroy(
+            [callbackId]()
+            {
+                System::RemoveAudioChangeCallback(callbackId);
+            });
+        if (Config::Get().audioLevelMeter)
+        {
+            uint32_t levelCallbackId = System::AddAudioLevelCallback(DynCtx::UpdateAudioLevel);
+            parent.AddOnDestroy(
+                [levelCallbackId]()
+                {
+                    System::RemoveAudioLevelCallback(levelCallbackId);
+                    DynCtx::audioMeter = nullptr;
+                    DynCtx::micMeter = nullptr;
+                });
+        }
     }
 
     void WidgetPackages(Widget& parent, Side)
@@ -804,7 +943,14 @@ namespace Bar
             }
             }
         }
-        box->AddTimer<Box>(DynCtx::UpdateBluetooth, DynCtx::updateTime);
+        // Only redrawn, when BlueZ reports a change
+        DynCtx::UpdateBluetooth();
+        uint32_t callbackId = System::AddBluetoothChangeCallback(DynCtx::UpdateBluetooth);
+        box->AddOnDestroy(
+            [callbackId]()
+            {
+                System::RemoveBluetoothChangeCallback(callbackId);
+            });
 
         parent.AddChild(std::move(box));
     }
@@ -812,6 +958,8 @@ namespace Bar
 
     void WidgetNetwork(Widget& parent, Side side)
     {
+        System::EnableSensor(System::Sensor::Network);
+
         auto eventBox = Widget::Create<EventBox>();
         Utils::SetTransform(*eventBox, {-1, false, SideToAlignment(side)});
         {
@@ -846,6 +994,7 @@ namespace Bar
                 sensor->SetLimitUp({(double)Config::Get().minUploadBytes, (double)Config::Get().maxUploadBytes});
                 sensor->SetLimitDown({(double)Config::Get().minDownloadBytes, (double)Config::Get().maxDownloadBytes});
                 sensor->SetAngle(Utils::GetAngle());
+                DynCtx::UpdateOnResample<NetworkSensor>(*sensor, DynCtx::UpdateNetwork);
                 sensor->AddTimer<NetworkSensor>(DynCtx::UpdateNetwork, DynCtx::updateTime);
                 Utils::SetTransform(*sensor, {(int)Config::Get().networkIconSize, true, Alignment::Fill});
 
@@ -875,25 +1024,95 @@ namespace Bar
         parent.AddChild(std::move(eventBox));
     }
 
+    void WidgetCPUCores(Widget& parent, Side side)
+    {
+        System::EnableSensor(System::Sensor::CPUCores);
+
+        auto eventBox = Widget::Create<EventBox>();
+        Utils::SetTransform(*eventBox, {-1, false, SideToAlignment(side)});
+        {
+            auto box = Widget::Create<Box>();
+            box->SetSpacing({0, false});
+            box->SetClass("cpu-cores-widget");
+            box->AddClass("widget");
+            box->AddClass("sensor");
+            box->SetOrientation(Utils::GetOrientation());
+            {
+                auto revealer = Widget::Create<Revealer>();
+                if (!Config::Get().sensorTooltips)
+                {
+                    revealer->SetTransition({Utils::GetTransitionType(SideToDefaultTransition(side)), 500});
+                    // Add event to eventbox for the revealer to open
+                    eventBox->SetHoverFn(
+                        [textRevealer = revealer.get()](EventBox&, bool hovered)
+                        {
+                            textRevealer->SetRevealed(hovered);
+                        });
+                    {
+                        auto text = Widget::Create<Text>();
+                        text->SetClass("cpu-cores-data-text");
+                        text->SetAngle(Utils::GetAngle());
+                        // Margins have the same problem as the WidgetSensor ones...
+                        Utils::SetTransform(*text, {-1, true, Alignment::Fill, 6, 6});
+                        DynCtx::cpuCoresText = text.get();
+                        revealer->AddChild(std::move(text));
+                    }
+                }
+
+                // One widget for all cores, instead of one sensor per core
+                auto strip = Widget::Create<SensorStrip>();
+                strip->SetClass("cpu-cores-util-progress");
+                strip->SetOrientation(Utils::GetOrientation());
+                DynCtx::UpdateOnResample<SensorStrip>(*strip, DynCtx::UpdateCPUCores);
+                strip->AddTimer<SensorStrip>(DynCtx::UpdateCPUCores, DynCtx::updateTime);
+                Utils::SetTransform(*strip, {(int)(System::GetCPUCoreCount() * Config::Get().cpuCoreSize), false, Alignment::Fill},
+                                    {(int)Config::Get().sensorSize, false, Alignment::Center});
+
+                switch (side)
+                {
+                case Side::Right:
+                case Side::Center:
+                {
+                    if (!Config::Get().sensorTooltips)
+                        box->AddChild(std::move(revealer));
+                    box->AddChild(std::move(strip));
+                    break;
+                }
+                case Side::Left:
+                {
+                    // Invert
+                    box->AddChild(std::move(strip));
+                    if (!Config::Get().sensorTooltips)
+                        box->AddChild(std::move(revealer));
+                    break;
+                }
+                }
+            }
+            eventBox->AddChild(std::move(box));
+        }
+
+        parent.AddChild(std::move(eventBox));
+    }
+
     void WidgetSensors(Widget& parent, Side side)
     {
         auto box = Widget::Create<Box>();
         box->SetClass("sensors");
         {
-            WidgetSensor(*box, DynCtx::UpdateDisk, "disk", DynCtx::diskText, side);
+            WidgetSensor(*box, System::Sensor::Disk, DynCtx::UpdateDisk, "disk", DynCtx::diskText, side);
 #if defined WITH_NVIDIA || defined WITH_AMD
             if (RuntimeConfig::Get().hasNvidia || RuntimeConfig::Get().hasAMD)
             {
-                WidgetSensor(*box, DynCtx::UpdateVRAM, "vram", DynCtx::vramText, side);
-                WidgetSensor(*box, DynCtx::UpdateGPU, "gpu", DynCtx::gpuText, side);
+                WidgetSensor(*box, System::Sensor::VRAM, DynCtx::UpdateVRAM, "vram", DynCtx::vramText, side);
+                WidgetSensor(*box, System::Sensor::GPU, DynCtx::UpdateGPU, "gpu", DynCtx::gpuText, side);
             }
 #endif
-            WidgetSensor(*box, DynCtx::UpdateRAM, "ram", DynCtx::ramText, side);
-            WidgetSensor(*box, DynCtx::UpdateCPU, "cpu", DynCtx::cpuText, side);
+            WidgetSensor(*box, System::Sensor::RAM, DynCtx::UpdateRAM, "ram", DynCtx::ramText, side);
+            WidgetSensor(*box, System::Sensor::CPU, DynCtx::UpdateCPU, "cpu", DynCtx::cpuText, side);
             // Only show battery percentage if battery folder is set and exists
-            if (System::GetBatteryPercentage() >= 0)
+            if (RuntimeConfig::Get().hasBattery)
             {
-                WidgetSensor(*box, DynCtx::UpdateBattery, "battery", DynCtx::batteryText, side);
+                WidgetSensor(*box, System::Sensor::Battery, DynCtx::UpdateBattery, "battery", DynCtx::batteryText, side);
             }
         }
         parent.AddChild(std::move(box));
@@ -1131,7 +1350,24 @@ namespace Bar
                     box->AddChild(std::move(workspace));
                 }
             }
-            box->AddTimer<Box>(DynCtx::UpdateWorkspaces, DynCtx::updateTimeFast);
+            bool eventDriven = System::SetWorkspaceChangeCallback(
+                [workspaceBox = box.get()]()
+                {
+                    DynCtx::UpdateWorkspaces(*workspaceBox);
+                });
+            if (eventDriven)
+            {
+                DynCtx::UpdateWorkspaces(*box);
+                box->AddOnDestroy(
+                    []()
+                    {
+                        System::SetWorkspaceChangeCallback(nullptr);
+                    });
+            }
+            else
+            {
+                box->AddTimer<Box>(DynCtx::UpdateWorkspaces, DynCtx::updateTimeFast);
+            }
             eventBox->AddChild(std::move(box));
         }
         parent.AddChild(std::move(eventBox));
@@ -1157,11 +1393,110 @@ namespace Bar
         title->SetAngle(Utils::GetAngle());
         title->SetClass("widget");
         title->AddClass("title-text");
-        title->SetText("Uninitialized");
-        title->AddTimer<Text>(DynCtx::UpdateTitle, DynCtx::updateTimeFast);
+        DynCtx::UpdateTitle(*title);
+        uint32_t callbackId = System::AddFocusedWindowChangeCallback(
+            [titleText = title.get()]()
+            {
+                DynCtx::UpdateTitle(*titleText);
+            });
+        title->AddOnDestroy(
+            [callbackId]()
+            {
+                System::RemoveFocusedWindowChangeCallback(callbackId);
+            });
         parent.AddChild(std::move(title));
     }
 
+    Text& WidgetNamedText(Widget& parent, Side side, const std::string& name)
+    {
+        auto text = Widget::Create<Text>();
+        Utils::SetTransform(*text, {-1, false, SideToAlignment(side)});
+        text->SetAngle(Utils::GetAngle());
+        text->SetClass("widget");
+        text->AddClass("custom-text");
+        text->AddClass(name + "-text");
+        DynCtx::namedTexts[name] = text.get();
+        text->AddOnDestroy(
+            [name]()
+            {
+                DynCtx::namedTexts.erase(name);
+            });
+        Text& textRef = *text;
+        parent.AddChild(std::move(text));
+        return textRef;
+    }
+
+    void WidgetCustom(Widget& parent, Side side, const std::string& name)
+    {
+        auto it = Config::Get().customWidgets.find(name);
+        if (it == Config::Get().customWidgets.end() || it->second.second.empty())
+        {
+            LOG("Warning: No command for custom widget " << name << ", add \"CustomWidget: " << name << ", <interval>, <command>\" to the config!");
+            return;
+        }
+        auto& [intervalStr, command] = it->second;
+
+        // 0 keeps the script running and shows every line it prints
+        uint32_t intervalMS = 0;
+        if (intervalStr != "continuous")
+        {
+            char* end;
+            double seconds = strtod(intervalStr.c_str(), &end);
+            if (end == intervalStr.c_str() || *end != '\0' || seconds <= 0)
+            {
+                LOG("Warning: Invalid interval \"" << intervalStr << "\" for custom widget " << name << ", expected seconds or \"continuous\"!");
+                return;
+            }
+            intervalMS = std::max((uint32_t)(seconds * 1000), 1u);
+        }
+
+        // Also a named text, so set-text still works on it
+        Text& text = WidgetNamedText(parent, side, name);
+        text.AddClass("custom-script");
+        uint32_t scriptId = Script::Start(command, intervalMS,
+                                          [&text](const std::string& line)
+                                          {
+                                              text.SetText(line);
+                                          });
+        text.AddOnDestroy(
+            [scriptId]()
+            {
+                Script::Stop(scriptId);
+            });
+    }
+
+    void WidgetNamedSensor(Widget& parent, Side side, const std::string& name)
+    {
+        auto box = Widget::Create<Box>();
+        box->SetClass(name + "-widget");
+        box->AddClass("widget");
+        box->AddClass("sensor");
+        Utils::SetTransform(*box, {-1, false, SideToAlignment(side)});
+
+        auto sensor = Widget::Create<Sensor>();
+        double angle = -90;
+        switch (Config::Get().location)
+        {
+        case 'T':
+        case 'B': angle = -90; break;
+        case 'L':
+        case 'R': angle = RotatedIcons() ? -90 : 0; break;
+        }
+        sensor->SetStyle({angle});
+        sensor->SetClass("custom-util-progress");
+        sensor->AddClass(name + "-util-progress");
+        Utils::SetTransform(*sensor, {(int)Config::Get().sensorSize, true, Alignment::Fill});
+        DynCtx::namedSensors[name] = sensor.get();
+        sensor->AddOnDestroy(
+            [name]()
+            {
+                DynCtx::namedSensors.erase(name);
+            });
+
+        box->AddChild(std::move(sensor));
+        parent.AddChild(std::move(box));
+    }
+
     void ChooseWidgetToDraw(const std::string& widgetName, Widget& parent, Side side)
     {
         if (widgetName == "Workspaces")
@@ -1223,14 +1558,14 @@ namespace Bar
         }
         if (widgetName == "Disk")
         {
-            WidgetSensor(parent, DynCtx::UpdateDisk, "disk", DynCtx::diskText, side);
+            WidgetSensor(parent, System::Sensor::Disk, DynCtx::UpdateDisk, "disk", DynCtx::diskText, side);
             return;
         }
         if (widgetName == "VRAM")
         {
 #if defined WITH_NVIDIA || defined WITH_AMD
             if (RuntimeConfig::Get().hasNvidia || RuntimeConfig::Get().hasAMD)
-                WidgetSensor(parent, DynCtx::UpdateVRAM, "vram", DynCtx::vramText, side);
+                WidgetSensor(parent, System::Sensor::VRAM, DynCtx::UpdateVRAM, "vram", DynCtx::vramText, side);
             return;
 #endif
         }
@@ -1238,25 +1573,30 @@ namespace Bar
         {
 #if defined WITH_NVIDIA || defined WITH_AMD
             if (RuntimeConfig::Get().hasNvidia || RuntimeConfig::Get().hasAMD)
-                WidgetSensor(parent, DynCtx::UpdateGPU, "gpu", DynCtx::gpuText, side);
+                WidgetSensor(parent, System::Sensor::GPU, DynCtx::UpdateGPU, "gpu", DynCtx::gpuText, side);
             return;
 #endif
         }
         if (widgetName == "RAM")
         {
-            WidgetSensor(parent, DynCtx::UpdateRAM, "ram", DynCtx::ramText, side);
+            WidgetSensor(parent, System::Sensor::RAM, DynCtx::UpdateRAM, "ram", DynCtx::ramText, side);
             return;
         }
         if (widgetName == "CPU")
         {
-            WidgetSensor(parent, DynCtx::UpdateCPU, "cpu", DynCtx::cpuText, side);
+            WidgetSensor(parent, System::Sensor::CPU, DynCtx::UpdateCPU, "cpu", DynCtx::cpuText, side);
+            return;
+        }
+        if (widgetName == "CPUCores")
+        {
+            WidgetCPUCores(parent, side);
             return;
         }
         if (widgetName == "Battery")
         {
             // Only show battery percentage if battery folder is set and exists
-            if (System::GetBatteryPercentage() >= 0)
-                WidgetSensor(parent, DynCtx::UpdateBattery, "battery", DynCtx::batteryText, side);
+            if (RuntimeConfig::Get().hasBattery)
+                WidgetSensor(parent, System::Sensor::Battery, DynCtx::UpdateBattery, "battery", DynCtx::batteryText, side);
             return;
         }
         if (widgetName == "Power")
@@ -1264,9 +1604,26 @@ namespace Bar
             WidgetPower(parent, side);
             return;
         }
+        // Named widgets, that are set through the control socket
+        if (widgetName.rfind("Text:", 0) == 0)
+        {
+            WidgetNamedText(parent, side, widgetName.substr(5));
+            return;
+        }
+        if (widgetName.rfind("Sensor:", 0) == 0)
+        {
+            WidgetNamedSensor(parent, side, widgetName.substr(7));
+            return;
+        }
+        if (widgetName.rfind("Custom:", 0) == 0)
+        {
+            WidgetCustom(parent, side, widgetName.substr(7));
+            return;
+        }
         LOG("Warning: Unkwown widget name " << widgetName << "!"
                                             << "\n\tKnown names are: Workspaces, Time, Tray, Packages, Audio, Bluetooth, Network, Sensors, Disk, "
-                                               "VRAM, GPU, RAM, CPU, Battery, Power, Title");
+                                               "VRAM, GPU, RAM, CPU, CPUCores, Battery, Power, Title, Text:<name>, Sensor:<name>, "
+                                               "Custom:<name>");
     }
 
     void Create(Window& window, const std::string& monitorName)
@@ -1274,6 +1631,9 @@ namespace Bar
         ASSERT(!window.GetName().empty(), "Error: The bar requires a specified monitor. Use 'gBar bar <monitor>' instead!");
         monitor = monitorName;
 
+        Control::AddCommand("set-text", DynCtx::SetNamedText);
+        Control::AddCommand("set-value", DynCtx::SetNamedValue);
+
         auto mainWidget = Widget::Create<Box>();
         mainWidget->SetOrientation(Utils::GetOrientation());
         mainWidget->SetSpacing({0, false});
@@ -0,0 +1,626 @@
+#include "BlueZ.h"
+#include "Common.h"
+#include "MainQueue.h"
+
+#ifdef WITH_BLUEZ
+#include <gio/gio.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+namespace BlueZ
+{
+    struct Adapter
+    {
+        std::string name;
+        bool powered = false;
+    };
+
+    struct Listener
+    {
+        uint32_t id;
+        std::function<void()> callback;
+        // Also woken up, if only the RSSI of a device changed
+        bool rssi;
+    };
+
+    static GDBusConnection* connection = nullptr;
+    static guint signalSubscriptions[3];
+    static guint nameWatch = 0;
+    // Whether the tables mirror a running BlueZ
+    static bool loaded = false;
+
+    // By object path. BlueZ puts the address into the device path, so the order is stable.
+    static std::map<std::string, Adapter> adapters;
+    static std::map<std::string, System::BluetoothDevice> devices;
+
+    // Rebuilt on the next GetInfo() after a change
+    static System::BluetoothInfo info;
+    static bool infoDirty = true;
+
+    static std::vector<Listener> listeners;
+    static uint32_t nextListenerId = 0;
+    static guint notifySource = 0;
+    // Whether more than the RSSI changed since the listeners were last called
+    static bool infoChanged = false;
+
+    // Pairing may wait for the user to confirm a code
+    constexpr int pairTimeoutMS = 60 * 1000;
+
+    struct Operation
+    {
+        GCancellable* cancellable;
+        ResultCallback onFinish;
+        // Device, while its Pair call is pending. Cancelling the call alone leaves BlueZ waiting for the pairing.
+        std::string pairingPath;
+    };
+    // One operation may be several calls (Pair, then Connect), which share the cancellable
+    static std::unordered_map<uint32_t, Operation> operations;
+    static uint32_t nextOperationId = 1;
+
+    static gboolean NotifyListeners(gpointer)
+    {
+        notifySource = 0;
+        bool rssiOnly = !infoChanged;
+        infoChanged = false;
+        for (size_t i = 0; i < listeners.size(); i++)
+        {
+            if (rssiOnly && !listeners[i].rssi)
+                continue;
+            // Copy, since the callback may remove itself
+            std::function<void()> callback = listeners[i].callback;
+            callback();
+        }
+        return G_SOURCE_REMOVE;
+    }
+
+    static void ScheduleNotify()
+    {
+        infoDirty = true;
+        // Discovery changes a lot of properties at once, tell the listeners only once
+        if (!notifySource)
+        {
+            notifySource = g_idle_add(NotifyListeners, nullptr);
+        }
+    }
+
+    static void Notify()
+    {
+        infoChanged = true;
+        ScheduleNotify();
+    }
+
+    // Discovery updates the RSSI of every device in range all the time. Only the device list cares, so the other listeners aren't woken.
+    static void NotifyRSSI()
+    {
+        ScheduleNotify();
+    }
+
+    // value is nullptr, if the property was invalidated. The setters return whether the value changed.
+    static bool SetString(std::string& target, GVariant* value)
+    {
+        const char* str = value && g_variant_is_of_type(value, G_VARIANT_TYPE_STRING) ? g_variant_get_string(value, nullptr) : "";
+        if (target == str)
+            return false;
+        target = str;
+        return true;
+    }
+
+    static bool SetBool(bool& target, GVariant* value)
+    {
+        bool val = value && g_variant_is_of_type(value, G_VARIANT_TYPE_BOOLEAN) && g_variant_get_boolean(value);
+        if (target == val)
+            return false;
+        target = val;
+        return true;
+    }
+
+    // RSSI jitters by a few dB all the time during discovery, small moves aren't worth a notification
+    constexpr int rssiThreshold = 5;
+    static bool SetRSSI(int16_t& target, GVariant* value)
+    {
+        int16_t val = value && g_variant_is_of_type(value, G_VARIANT_TYPE_INT16) ? g_variant_get_int16(value) : 0;
+        // Appearing or disappearing always counts
+        if (val == target || (val != 0 && target != 0 && std::abs(val - target) < rssiThreshold))
+            return false;
+        target = val;
+        return true;
+    }
+
+    static bool SetPercentage(int32_t& target, GVariant* value)
+    {
+        int32_t val = value && g_variant_is_of_type(value, G_VARIANT_TYPE_BYTE) ? g_variant_get_byte(value) : -1;
+        if (target == val)
+            return false;
+        target = val;
+        return true;
+    }
+
+    static bool ApplyProperty(Adapter& adapter, const char* name, GVariant* value)
+    {
+        if (strcmp(name, "Name") == 0)
+            return SetString(adapter.name, value);
+        if (strcmp(name, "Powered") == 0)
+            return SetBool(adapter.powered, value);
+        return false;
+    }
+
+    static bool ApplyProperty(System::BluetoothDevice& device, const char* name, GVariant* value)
+    {
+        if (strcmp(name, "Address") == 0)
+            return SetString(device.mac, value);
+        if (strcmp(name, "Name") == 0)
+            return SetString(device.name, value);
+        if (strcmp(name, "Icon") == 0)
+            return SetString(device.type, value);
+        if (strcmp(name, "Connected") == 0)
+            return SetBool(device.connected, value);
+        if (strcmp(name, "Paired") == 0)
+            return SetBool(device.paired, value);
+        if (strcmp(name, "RSSI") == 0)
+        {
+            // Has its own notification
+            if (SetRSSI(device.rssi, value))
+                NotifyRSSI();
+            return false;
+        }
+        // From Battery1, which lives on the device object
+        if (strcmp(name, "Percentage") == 0)
+            return SetPercentage(device.battery, value);
+        // Everything else isn't shown, so it doesn't wake up anyone
+        return false;
+    }
+
+    // properties: a{sv}, invalidated: as (may be nullptr). Only creates the object, if add is set. Returns whether something changed.
+    template<typename Object>
+    static bool ApplyProperties(std::map<std::string, Object>& table, const char* path, GVariantIter* properties, GVariantIter* invalidated,
+                                bool add)
+    {
+        bool changed = false;
+        auto it = table.find(path);
+        if (it == table.end())
+        {
+            if (!add)
+                return false;
+            it = table.emplace(path, Object{}).first;
+            changed = true;
+        }
+
+        const char* name;
+        GVariant* value;
+        while (g_variant_iter_loop(properties, "{&sv}", &name, &value))
+        {
+            changed |= ApplyProperty(it->second, name, value);
+        }
+        if (invalidated)
+        {
+            while (g_variant_iter_loop(invalidated, "&s", &name))
+            {
+                changed |= ApplyProperty(it->second, name, nullptr);
+            }
+        }
+        return changed;
+    }
+
+    static bool ApplyInterface(const char* path, const char* interface, GVariantIter* properties, GVariantIter* invalidated, bool add)
+    {
+        if (strcmp(interface, "org.bluez.Adapter1") == 0)
+            return ApplyProperties(adapters, path, properties, invalidated, add);
+        // Battery1 can come before Device1 in the same InterfacesAdded, so both may create the device
+        if (strcmp(interface, "org.bluez.Device1") == 0 || strcmp(interface, "org.bluez.Battery1") == 0)
+            return ApplyProperties(devices, path, properties, invalidated, add);
+        return false;
+    }
+
+    // interfaces: a{sa{sv}}
+    static bool AddInterfaces(const char* path, GVariantIter* interfaces)
+    {
+        bool changed = false;
+        const char* interface;
+        GVariantIter* properties;
+        while (g_variant_iter_next(interfaces, "{&sa{sv}}", &interface, &properties))
+        {
+            changed |= ApplyInterface(path, interface, properties, nullptr, true);
+            g_variant_iter_free(properties);
+        }
+        return changed;
+    }
+
+    // objects: (a{oa{sa{sv}}}) from GetManagedObjects
+    static void Load(GVariant* objects)
+    {
+        adapters.clear();
+        devices.clear();
+
+        GVariantIter* objectIter;
+        g_variant_get(objects, "(a{oa{sa{sv}}})", &objectIter);
+        const char* path;
+        GVariantIter* interfaces;
+        while (g_variant_iter_next(objectIter, "{&oa{sa{sv}}}", &path, &interfaces))
+        {
+            AddInterfaces(path, interfaces);
+            g_variant_iter_free(interfaces);
+        }
+        g_variant_iter_free(objectIter);
+
+        loaded = true;
+        Notify();
+    }
+
+    static void OnInterfacesAdded(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*, GVariant* params, gpointer)
+    {
+        const char* path;
+        GVariantIter* interfaces;
+        g_variant_get(params, "(&oa{sa{sv}})", &path, &interfaces);
+        if (AddInterfaces(path, interfaces))
+        {
+            Notify();
+        }
+        g_variant_iter_free(interfaces);
+    }
+
+    static void OnInterfacesRemoved(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*, GVariant* params, gpointer)
+    {
+        const char* path;
+        GVariantIter* interfaces;
+        g_variant_get(params, "(&oas)", &path, &interfaces);
+        bool changed = false;
+        const char* interface;
+        while (g_variant_iter_loop(interfaces, "&s", &interface))
+        {
+            if (strcmp(interface, "org.bluez.Adapter1") == 0)
+                changed |= adapters.erase(path) != 0;
+            else if (strcmp(interface, "org.bluez.Device1") == 0)
+                changed |= devices.erase(path) != 0;
+            else if (strcmp(interface, "org.bluez.Battery1") == 0)
+            {
+                auto it = devices.find(path);
+                if (it != devices.end())
+                    changed |= SetPercentage(it->second.battery, nullptr);
+            }
+        }
+        g_variant_iter_free(interfaces);
+        if (changed)
+        {
+            Notify();
+        }
+    }
+
+    static void OnPropertiesChanged(GDBusConnection*, const gchar*, const gchar* path, const gchar*, const gchar*, GVariant* params, gpointer)
+    {
+        const char* interface;
+        GVariantIter* properties;
+        GVariantIter* invalidated;
+        g_variant_get(params, "(&sa{sv}as)", &interface, &properties, &invalidated);
+        if (ApplyInterface(path, interface, properties, invalidated, false))
+        {
+            Notify();
+        }
+        g_variant_iter_free(properties);
+        g_variant_iter_free(invalidated);
+    }
+
+    static void OnBlueZAppeared(GDBusConnection*, const gchar*, const gchar*, gpointer)
+    {
+        if (loaded)
+            return;
+        // BlueZ was restarted, the signals only tell us about changes from now on
+        g_dbus_connection_call(connection, "org.bluez", "/", "org.freedesktop.DBus.ObjectManager", "GetManagedObjects", nullptr,
+                               G_VARIANT_TYPE("(a{oa{sa{sv}}})"), G_DBUS_CALL_FLAGS_NONE, -1, nullptr,
+                               [](GObject* source, GAsyncResult* res, gpointer)
+                               {
+                                   GError* err = nullptr;
+                                   GVariant* objects = g_dbus_connection_call_finish((GDBusConnection*)source, res, &err);
+                                   if (!objects)
+                                   {
+                                       LOG("BlueZ: Cannot reload objects: " << err->message);
+                                       g_error_free(err);
+                                       return;
+                                   }
+                                   Load(objects);
+                                   g_variant_unref(objects);
+                               },
+                               nullptr);
+    }
+
+    static void OnBlueZVanished(GDBusConnection*, const gchar*, gpointer)
+    {
+        if (!loaded)
+            return;
+        LOG("BlueZ: Service went away");
+        loaded = false;
+        adapters.clear();
+        devices.clear();
+        Notify();
+    }
+
+    static uint32_t BeginOperation(ResultCallback&& onFinish)
+    {
+        uint32_t id = nextOperationId++;
+        operations.emplace(id, Operation{g_cancellable_new(), std::move(onFinish), {}});
+        return id;
+    }
+
+    static void FinishOperation(uint32_t id, const Result& result)
+    {
+        auto it = operations.find(id);
+        if (it == operations.end())
+            return;
+        ResultCallback onFinish = std::move(it->second.onFinish);
+        g_object_unref(it->second.cancellable);
+        operations.erase(it);
+        onFinish(result);
+    }
+
+    // For errors, that are known before anything is sent. Still reported later, like every other result.
+    static uint32_t FailOperation(uint32_t id, const std::string& error, const std::string& message)
+    {
+        PostToMain(
+            [id, result = Result{error, message}]()
+            {
+                FinishOperation(id, result);
+            });
+        return id;
+    }
+
+    struct Call
+    {
+        uint32_t operation;
+        // Called instead of finishing the operation, if the call succeeded
+        std::function<void()> next;
+    };
+
+    static void OnCallFinished(GObject* source, GAsyncResult* res, gpointer data)
+    {
+        std::unique_ptr<Call> call((Call*)data);
+        GError* err = nullptr;
+        GVariant* reply = g_dbus_connection_call_finish((GDBusConnection*)source, res, &err);
+        if (reply)
+            g_variant_unref(reply);
+
+        auto it = operations.find(call->operation);
+        if (it == operations.end())
+        {
+            // Cancelled
+            if (err)
+                g_error_free(err);
+            return;
+        }
+        it->second.pairingPath.clear();
+        if (err)
+        {
+            Result result;
+            gchar* remoteError = g_dbus_error_get_remote_error(err);
+            // Local errors (e.g. a timeout) don't have a D-Bus name
+            result.error = remoteError ? remoteError : g_quark_to_string(err->domain);
+            g_dbus_error_strip_remote_error(err);
+            result.message = err->message;
+            g_free(remoteError);
+            g_error_free(err);
+            FinishOperation(call->operation, result);
+            return;
+        }
+        if (call->next)
+            call->next();
+        else
+            FinishOperation(call->operation, {});
+    }
+
+    static void CallMethod(uint32_t operation, const std::string& path, const char* interface, const char* method, int timeoutMS,
+                           std::function<void()>&& next = {})
+    {
+        auto it = operations.find(operation);
+        if (it == operations.end())
+            return;
+        g_dbus_connection_call(connection, "org.bluez", path.c_str(), interface, method, nullptr, nullptr, G_DBUS_CALL_FLAGS_NONE, timeoutMS,
+                               it->second.cancellable, OnCallFinished, new Call{operation, std::move(next)});
+    }
+
+    static const std::string* FindDevicePath(const std::string& mac)
+    {
+        for (auto& [path, device] : devices)
+        {
+            if (device.mac == mac)
+                return &path;
+        }
+        return nullptr;
+    }
+
+    static const std::string* FindAdapterPath()
+    {
+        const std::string* found = nullptr;
+        for (auto& [path, adapter] : adapters)
+        {
+            if (adapter.powered)
+                return &path;
+            if (!found)
+                found = &path;
+        }
+        return found;
+    }
+
+    uint32_t Connect(const std::string& mac, ResultCallback&& onFinish)
+    {
+        uint32_t id = BeginOperation(std::move(onFinish));
+        const std::string* path = FindDevicePath(mac);
+        if (!connection || !path)
+            return FailOperation(id, "org.bluez.Error.DoesNotExist", "Unknown device " + mac);
+
+        auto connect = [id, path = *path]()
+        {
+            CallMethod(id, path, "org.bluez.Device1", "Connect", -1);
+        };
+        if (devices[*path].paired)
+        {
+            connect();
+        }
+        else
+        {
+            operations[id].pairingPath = *path;
+            CallMethod(id, *path, "org.bluez.Device1", "Pair", pairTimeoutMS, std::move(connect));
+        }
+        return id;
+    }
+
+    uint32_t Disconnect(const std::string& mac, ResultCallback&& onFinish)
+    {
+        uint32_t id = BeginOperation(std::move(onFinish));
+        const std::string* path = FindDevicePath(mac);
+        if (!connection || !path)
+            return FailOperation(id, "org.bluez.Error.DoesNotExist", "Unknown device " + mac);
+        CallMethod(id, *path, "org.bluez.Device1", "Disconnect", -1);
+        return id;
+    }
+
+    static uint32_t CallAdapter(const char* method, ResultCallback&& onFinish)
+    {
+        uint32_t id = BeginOperation(std::move(onFinish));
+        const std::string* path = FindAdapterPath();
+        if (!connection || !path)
+            return FailOperation(id, "org.bluez.Error.NotReady", "No bluetooth adapter");
+        CallMethod(id, *path, "org.bluez.Adapter1", method, -1);
+        return id;
+    }
+
+    uint32_t StartDiscovery(ResultCallback&& onFinish)
+    {
+        return CallAdapter("StartDiscovery", std::move(onFinish));
+    }
+
+    uint32_t StopDiscovery(ResultCallback&& onFinish)
+    {
+        return CallAdapter("StopDiscovery", std::move(onFinish));
+    }
+
+    void Cancel(uint32_t id)
+    {
+        auto it = operations.find(id);
+        if (it == operations.end())
+            return;
+        g_cancellable_cancel(it->second.cancellable);
+        g_object_unref(it->second.cancellable);
+        if (!it->second.pairingPath.empty() && connection)
+        {
+            // Nobody waits for the reply. BlueZ answers the pending Pair call with AuthenticationCanceled.
+            g_dbus_connection_call(connection, "org.bluez", it->second.pairingPath.c_str(), "org.bluez.Device1", "CancelPairing", nullptr, nullptr,
+                                   G_DBUS_CALL_FLAGS_NONE, -1, nullptr, nullptr, nullptr);
+        }
+        operations.erase(it);
+    }
+
+    bool Init()
+    {
+        GError* err = nullptr;
+        connection = g_bus_get_sync(G_BUS_TYPE_SYSTEM, nullptr, &err);
+        if (!connection)
+        {
+            LOG("Can't connect to d-bus! Disabling Bluetooth!");
+            LOG(err->message);
+            g_error_free(err);
+            return false;
+        }
+
+        // Subscribe before loading, so no change between the snapshot and the subscription is lost
+        signalSubscriptions[0] = g_dbus_connection_signal_subscribe(connection, "org.bluez", "org.freedesktop.DBus.ObjectManager", "InterfacesAdded",
+                                                                    nullptr, nullptr, G_DBUS_SIGNAL_FLAGS_NONE, OnInterfacesAdded, nullptr, nullptr);
+        signalSubscriptions[1] =
+            g_dbus_connection_signal_subscribe(connection, "org.bluez", "org.freedesktop.DBus.ObjectManager", "InterfacesRemoved", nullptr, nullptr,
+                                               G_DBUS_SIGNAL_FLAGS_NONE, OnInterfacesRemoved, nullptr, nullptr);
+        signalSubscriptions[2] = g_dbus_connection_signal_subscribe(connection, "org.bluez", "org.freedesktop.DBus.Properties", "PropertiesChanged",
+                                                                    nullptr, nullptr, G_DBUS_SIGNAL_FLAGS_NONE, OnPropertiesChanged, nullptr, nullptr);
+
+        GVariant* objects = g_dbus_connection_call_sync(connection, "org.bluez", "/", "org.freedesktop.DBus.ObjectManager", "GetManagedObjects",
+                                                        nullptr, G_VARIANT_TYPE("(a{oa{sa{sv}}})"), G_DBUS_CALL_FLAGS_NONE, -1, nullptr, &err);
+        if (!objects)
+        {
+            LOG("Can't connect to BlueZ d-bus! Disabling Bluetooth!");
+            LOG(err->message);
+            g_error_free(err);
+            Shutdown();
+            return false;
+        }
+        Load(objects);
+        g_variant_unref(objects);
+
+        nameWatch = g_bus_watch_name_on_connection(connection, "org.bluez", G_BUS_NAME_WATCHER_FLAGS_NONE, OnBlueZAppeared, OnBlueZVanished,
+                                                   nullptr, nullptr);
+        return true;
+    }
+
+    void Shutdown()
+    {
+        if (!connection)
+            return;
+        if (nameWatch)
+        {
+            g_bus_unwatch_name(nameWatch);
+            nameWatch = 0;
+        }
+        for (guint& subscription : signalSubscriptions)
+        {
+            g_dbus_connection_signal_unsubscribe(connection, subscription);
+            subscription = 0;
+        }
+        if (notifySource)
+        {
+            g_source_remove(notifySource);
+            notifySource = 0;
+        }
+        infoChanged = false;
+        while (!operations.empty())
+        {
+            Cancel(operations.begin()->first);
+        }
+        g_object_unref(connection);
+        connection = nullptr;
+
+        loaded = false;
+        adapters.clear();
+        devices.clear();
+        infoDirty = true;
+        listeners.clear();
+    }
+
+    const System::BluetoothInfo& GetInfo()
+    {
+        if (infoDirty)
+        {
+            info.defaultController.clear();
+            for (auto& [path, adapter] : adapters)
+            {
+                if (adapter.powered)
+                {
+                    info.defaultController = adapter.name;
+                }
+            }
+            info.devices.clear();
+            for (auto& [path, device] : devices)
+            {
+                info.devices.push_back(device);
+            }
+            infoDirty = false;
+        }
+        return info;
+    }
+
+    uint32_t AddListener(std::function<void()>&& callback, bool rssi)
+    {
+        uint32_t id = nextListenerId++;
+        listeners.push_back({id, std::move(callback), rssi});
+        return id;
+    }
+
+    void RemoveListener(uint32_t id)
+    {
+        listeners.erase(std::remove_if(listeners.begin(), listeners.end(),
+                                       [&](const Listener& listener)
+                                       {
+                                           return listener.id == id;
+                                       }),
+                        listeners.end());
+    }
+}
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+#include "System.h"
+
+#ifdef WITH_BLUEZ
+// Mirrors the BlueZ adapters and devices in memory. The system bus connection is kept open, the table is filled once with
+// GetManagedObjects and then kept current from the InterfacesAdded/InterfacesRemoved/PropertiesChanged signals, so reading it is free.
+// The "system bus" is whatever DBUS_SYSTEM_BUS_ADDRESS points to, so a mock BlueZ on a private bus can stand in for the real one
+// (see data/mock_bluez.py).
+namespace BlueZ
+{
+    // Returns false, if BlueZ isn't reachable
+    bool Init();
+    void Shutdown();
+
+    const System::BluetoothInfo& GetInfo();
+
+    // Called on the main thread, once per main loop iteration at most, after the table changed. Returns an id for removal.
+    // Changes of only the RSSI are reported to listeners with rssi set alone.
+    uint32_t AddListener(std::function<void()>&& callback, bool rssi = false);
+    void RemoveListener(uint32_t id);
+
+    struct Result
+    {
+        // Empty on success, otherwise the D-Bus error name (e.g. org.bluez.Error.AuthenticationFailed)
+        std::string error;
+        std::string message;
+    };
+    using ResultCallback = std::function<void(const Result& result)>;
+
+    // Asynchronous BlueZ calls. onFinish is always called later on the main thread, never from within the call. Each returns an id for Cancel().
+
+    // Pairs first, if the device isn't paired yet
+    uint32_t Connect(const std::string& mac, ResultCallback&& onFinish);
+    uint32_t Disconnect(const std::string& mac, ResultCallback&& onFinish);
+    // On the powered adapter
+    uint32_t StartDiscovery(ResultCallback&& onFinish);
+    uint32_t StopDiscovery(ResultCallback&& onFinish);
+    // Cancels the pending D-Bus call, and a pending pairing in BlueZ with CancelPairing. onFinish isn't called anymore.
+    void Cancel(uint32_t id);
+}
+#endif
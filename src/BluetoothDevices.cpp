@@ -1,9 +1,9 @@
 #include "BluetoothDevices.h"
 #include "System.h"
-#include <mutex>
 #include <unordered_map>
 #include <string>
 #include <algorithm>
+#include <memory>
 
 #ifdef WITH_BLUEZ
 namespace BluetoothDevices
@@ -27,178 +27,212 @@ namespace BluetoothDevices
             DeviceState state{};
         };
 
-        std::mutex deviceMutex;
-        std::vector<BTDeviceWithState> devices;
+        // By MAC. Nodes are stable, so sortedDevices can point into it.
+        std::unordered_map<std::string, BTDeviceWithState> devices;
+        std::vector<BTDeviceWithState*> sortedDevices;
+
+        // Only the visible part of sortedDevices exists as widgets. A row remembers what it shows, so it is only touched on a change.
+        struct Row
+        {
+            Button* button;
+            std::string mac;
+            std::string text;
+            const char* stateClass = nullptr;
+            bool failed = false;
+        };
+        std::vector<Row> rows;
+        size_t scrollOffset = 0;
+
         Box* deviceListBox;
+        Text* scrollInfo;
+        std::string scrollInfoText;
         Window* win;
         bool scanning = false;
+        // Connect/disconnect requests, that are still running. Cancelled, when the window closes.
+        std::vector<uint32_t> pendingRequests;
 
-        void OnClick(Button& button, BTDeviceWithState& device)
-        {
-            DeviceState& state = device.state;
-
-            // Clear failed bit
-            state &= ~DeviceState::Failed;
-            button.RemoveClass("failed");
+        void InvalidateDeviceUI();
 
-            // Only try to connect, if we know we're already disconnected and we haven't requested before(Same for disconnect)
-            if (FLAG_CHECK(state, DeviceState::Disconnected) && !FLAG_CHECK(state, DeviceState::RequestConnect))
-            {
-                button.AddClass("active");
-                button.RemoveClass("inactive");
-                state |= DeviceState::RequestConnect;
-
-                System::ConnectBTDevice(device.device,
-                                        [&dev = device, &but = button](bool success, System::BluetoothDevice&)
-                                        {
-                                            deviceMutex.lock();
-                                            if (!success)
-                                            {
-                                                dev.state &= ~DeviceState::RequestConnect;
-                                                dev.state |= DeviceState::Failed;
-                                                but.AddClass("failed");
-                                            }
-                                            deviceMutex.unlock();
-                                        });
-            }
-            else if (FLAG_CHECK(state, DeviceState::Connected) && !FLAG_CHECK(state, DeviceState::RequestDisconnect))
-            {
-                button.AddClass("inactive");
-                button.RemoveClass("active");
-                state |= DeviceState::RequestDisconnect;
+        void OnRequestFinished(uint32_t requestId, const std::string& mac, DeviceState request, bool success)
+        {
+            pendingRequests.erase(std::remove(pendingRequests.begin(), pendingRequests.end(), requestId), pendingRequests.end());
+            if (success)
+                return;
+            // The device may be gone in the meantime
+            auto it = devices.find(mac);
+            if (it == devices.end())
+                return;
+            it->second.state &= ~request;
+            it->second.state |= DeviceState::Failed;
+            InvalidateDeviceUI();
+        }
 
-                System::DisconnectBTDevice(device.device,
-                                           [&dev = device, &but = button](bool success, System::BluetoothDevice&)
-                                           {
-                                               deviceMutex.lock();
-                                               if (!success)
-                                               {
-                                                   dev.state &= ~DeviceState::RequestDisconnect;
-                                                   dev.state |= DeviceState::Failed;
-                                                   but.AddClass("failed");
-                                               }
-                                               deviceMutex.unlock();
-                                           });
-            }
+        // The id is only known after the call returned, but the callback is never called before that
+        template<typename Fn>
+        void Request(Fn&& fn, const System::BluetoothDevice& device, DeviceState request)
+        {
+            auto id = std::make_shared<uint32_t>(0);
+            *id = fn(device,
+                     [id, mac = device.mac, request](bool success)
+                     {
+                         OnRequestFinished(*id, mac, request, success);
+                     });
+            pendingRequests.push_back(*id);
         }
 
-        void UpdateDeviceUIElem(Button& button, BTDeviceWithState& device)
+        void UpdateRow(Row& row, const BTDeviceWithState& device)
         {
-            if (device.device.name.size())
+            row.mac = device.device.mac;
+
+            std::string text = device.device.name.size() ? System::BTTypeToIcon(device.device) + device.device.name : device.device.mac;
+            if (device.device.battery >= 0)
             {
-                button.SetText(System::BTTypeToIcon(device.device) + device.device.name);
+                text += "  " + std::to_string(device.device.battery) + "%";
             }
-            else
+            if (text != row.text)
             {
-                button.SetText(device.device.mac);
+                row.button->SetText(text);
+                row.text = std::move(text);
             }
+
             bool requestConnect = FLAG_CHECK(device.state, DeviceState::RequestConnect);
             bool requestDisconnect = FLAG_CHECK(device.state, DeviceState::RequestDisconnect);
+            const char* stateClass = row.stateClass;
             if (requestConnect || (!requestDisconnect && FLAG_CHECK(device.state, DeviceState::Connected)))
             {
-                button.AddClass("active");
-                button.RemoveClass("inactive");
+                stateClass = "active";
             }
             else if (requestDisconnect || (!requestConnect && FLAG_CHECK(device.state, DeviceState::Disconnected)))
             {
-                button.AddClass("inactive");
-                button.RemoveClass("active");
+                stateClass = "inactive";
             }
-            if (FLAG_CHECK(device.state, DeviceState::Failed))
+            if (stateClass != row.stateClass)
             {
-                button.AddClass("failed");
+                if (row.stateClass)
+                    row.button->RemoveClass(row.stateClass);
+                row.button->AddClass(stateClass);
+                row.stateClass = stateClass;
             }
-            else
+
+            bool failed = FLAG_CHECK(device.state, DeviceState::Failed);
+            if (failed != row.failed)
             {
-                button.RemoveClass("failed");
+                if (failed)
+                    row.button->AddClass("failed");
+                else
+                    row.button->RemoveClass("failed");
+                row.failed = failed;
             }
+        }
 
-            button.OnClick(
-                [&dev = device](Button& button)
-                {
-                    OnClick(button, dev);
-                });
+        void OnClick(size_t rowIdx)
+        {
+            auto it = devices.find(rows[rowIdx].mac);
+            if (it == devices.end())
+                return;
+            BTDeviceWithState& device = it->second;
+            DeviceState& state = device.state;
+
+            // Clear failed bit
+            state &= ~DeviceState::Failed;
+
+            // Only try to connect, if we know we're already disconnected and we haven't requested before(Same for disconnect)
+            if (FLAG_CHECK(state, DeviceState::Disconnected) && !FLAG_CHECK(state, DeviceState::RequestConnect))
+            {
+                state |= DeviceState::RequestConnect;
+                Request(System::ConnectBTDevice, device.device, DeviceState::RequestConnect);
+            }
+            else if (FLAG_CHECK(state, DeviceState::Connected) && !FLAG_CHECK(state, DeviceState::RequestDisconnect))
+            {
+                state |= DeviceState::RequestDisconnect;
+                Request(System::DisconnectBTDevice, device.device, DeviceState::RequestDisconnect);
+            }
+            UpdateRow(rows[rowIdx], device);
         }
 
         void InvalidateDeviceUI()
         {
+            size_t maxRows = std::max<size_t>(Config::Get().btMaxVisibleDevices, 1);
+            size_t numRows = std::min(sortedDevices.size(), maxRows);
+            scrollOffset = std::min(scrollOffset, sortedDevices.size() - numRows);
+
             // Shrink
-            if (deviceListBox->GetChilds().size() > devices.size())
+            while (rows.size() > numRows)
             {
-                for (size_t i = deviceListBox->GetChilds().size() - 1; i >= devices.size(); i--)
-                {
-                    deviceListBox->RemoveChild(i);
-                }
+                deviceListBox->RemoveChild(rows.size() - 1);
+                rows.pop_back();
             }
-
-            size_t idx = 0;
-            for (auto& device : devices)
+            // Grow
+            while (rows.size() < numRows)
             {
-                if (idx >= deviceListBox->GetChilds().size())
-                {
-                    // Create new
-                    auto button = Widget::Create<Button>();
-                    button->SetClass("bt-button");
-                    deviceListBox->AddChild(std::move(button));
-                }
+                auto button = Widget::Create<Button>();
+                button->SetClass("bt-button");
+                // The row is reused for whatever device scrolls into it, so the callback only knows the index
+                button->OnClick(
+                    [rowIdx = rows.size()](Button&)
+                    {
+                        OnClick(rowIdx);
+                    });
+                Row row{};
+                row.button = button.get();
+                rows.push_back(std::move(row));
+                deviceListBox->AddChild(std::move(button));
+            }
 
-                // Initialise
-                UpdateDeviceUIElem((Button&)*deviceListBox->GetChilds()[idx], device);
+            for (size_t i = 0; i < rows.size(); i++)
+            {
+                UpdateRow(rows[i], *sortedDevices[scrollOffset + i]);
+            }
 
-                idx++;
+            std::string info;
+            if (numRows < sortedDevices.size())
+            {
+                info = std::to_string(scrollOffset + 1) + "-" + std::to_string(scrollOffset + numRows) + " / " + std::to_string(sortedDevices.size());
+            }
+            if (info != scrollInfoText)
+            {
+                scrollInfo->SetText(info);
+                scrollInfoText = std::move(info);
             }
         }
 
-        TimerResult OnUpdate(Widget&)
+        void OnUpdate()
         {
             // Invalidate each current device
-            for (auto& device : devices)
+            for (auto& [mac, device] : devices)
             {
                 device.state |= DeviceState::Invalid;
             }
 
             for (auto& device : System::GetBluetoothInfo().devices)
             {
-                auto stateDevIt = std::find_if(devices.begin(), devices.end(),
-                                               [&](auto& x)
-                                               {
-                                                   return device.mac == x.device.mac;
-                                               });
-                BTDeviceWithState* stateDev = nullptr;
-                if (stateDevIt != devices.end())
-                {
-                    stateDev = &*stateDevIt;
-                }
-                else
-                {
-                    devices.push_back({});
-                    stateDev = &devices.back();
-                }
+                // Default constructs new devices
+                BTDeviceWithState& stateDev = devices[device.mac];
                 // This device exists
-                stateDev->state &= ~DeviceState::Invalid;
+                stateDev.state &= ~DeviceState::Invalid;
                 if (device.connected)
                 {
                     // Clear any requests, it is now connected
-                    stateDev->state &= ~DeviceState::RequestConnect;
+                    stateDev.state &= ~DeviceState::RequestConnect;
 
-                    stateDev->state &= ~DeviceState::Disconnected;
-                    stateDev->state |= DeviceState::Connected;
+                    stateDev.state &= ~DeviceState::Disconnected;
+                    stateDev.state |= DeviceState::Connected;
                 }
                 else
                 {
-                    stateDev->state &= ~DeviceState::RequestDisconnect;
+                    stateDev.state &= ~DeviceState::RequestDisconnect;
 
-                    stateDev->state &= ~DeviceState::Connected;
-                    stateDev->state |= DeviceState::Disconnected;
+                    stateDev.state &= ~DeviceState::Connected;
+                    stateDev.state |= DeviceState::Disconnected;
                 }
-                stateDev->device = device;
+                stateDev.device = device;
             }
             // Erase all invalid
             for (auto it = devices.begin(); it != devices.end();)
             {
-                if (FLAG_CHECK(it->state, DeviceState::Invalid))
+                if (FLAG_CHECK(it->second.state, DeviceState::Invalid))
                 {
-                    LOG("Removing " << it->device.name);
+                    LOG("Removing " << it->second.device.name);
                     it = devices.erase(it);
                 }
                 else
@@ -207,26 +241,49 @@ namespace BluetoothDevices
                 }
             }
 
-            // Sort devices by, whether they're connected or not
-            std::sort(devices.begin(), devices.end(),
-                      [](auto& a, auto& b)
+            sortedDevices.clear();
+            for (auto& [mac, device] : devices)
+            {
+                sortedDevices.push_back(&device);
+            }
+            // Connected devices first, then the strongest signal. Devices without signal (not in range, or not discovering) last.
+            std::sort(sortedDevices.begin(), sortedDevices.end(),
+                      [](auto* a, auto* b)
                       {
-                          auto& deviceA = a.device;
-                          auto& deviceB = b.device;
-                          if (deviceA.connected && !deviceB.connected)
+                          auto& deviceA = a->device;
+                          auto& deviceB = b->device;
+                          if (deviceA.connected != deviceB.connected)
+                          {
+                              return deviceA.connected;
+                          }
+                          if (deviceA.rssi != deviceB.rssi)
                           {
-                              return true;
+                              if (deviceA.rssi == 0 || deviceB.rssi == 0)
+                                  return deviceB.rssi == 0;
+                              return deviceA.rssi > deviceB.rssi;
                           }
-                          else if (deviceB.connected && !deviceA.connected)
+                          if (deviceA.name != deviceB.name)
                           {
-                              return false;
+                              return deviceA.name < deviceB.name;
                           }
-                          return deviceA.name < deviceB.name;
+                          return deviceA.mac < deviceB.mac;
                       });
 
             InvalidateDeviceUI();
+        }
 
-            return TimerResult::Ok;
+        void Scroll(EventBox&, ScrollDirection direction)
+        {
+            if (direction == ScrollDirection::Up && scrollOffset > 0)
+            {
+                scrollOffset--;
+            }
+            else if (direction == ScrollDirection::Down)
+            {
+                // Clamped by InvalidateDeviceUI
+                scrollOffset++;
+            }
+            InvalidateDeviceUI();
         }
 
         void Close(Button&)
@@ -278,12 +335,35 @@ namespace BluetoothDevices
 
     void WidgetBody(Widget& parentWidget)
     {
-        auto bodyBox = Widget::Create<Box>();
-        DynCtx::deviceListBox = bodyBox.get();
-        bodyBox->SetOrientation(Orientation::Vertical);
-        bodyBox->SetClass("bt-body-box");
-        bodyBox->AddTimer<Widget>(DynCtx::OnUpdate, 100);
-        parentWidget.AddChild(std::move(bodyBox));
+        auto eventBox = Widget::Create<EventBox>();
+        eventBox->SetScrollFn(DynCtx::Scroll);
+        {
+            auto bodyBox = Widget::Create<Box>();
+            DynCtx::deviceListBox = bodyBox.get();
+            bodyBox->SetOrientation(Orientation::Vertical);
+            bodyBox->SetClass("bt-body-box");
+            eventBox->AddChild(std::move(bodyBox));
+        }
+        parentWidget.AddChild(std::move(eventBox));
+
+        auto scrollInfo = Widget::Create<Text>();
+        scrollInfo->SetClass("bt-scroll-info");
+        DynCtx::scrollInfo = scrollInfo.get();
+        parentWidget.AddChild(std::move(scrollInfo));
+
+        // Only refreshed, when BlueZ reports a change. The list is sorted by RSSI, so it needs those changes too.
+        DynCtx::OnUpdate();
+        uint32_t callbackId = System::AddBluetoothChangeCallback(DynCtx::OnUpdate, true);
+        DynCtx::deviceListBox->AddOnDestroy(
+            [callbackId]()
+            {
+                System::RemoveBluetoothChangeCallback(callbackId);
+                DynCtx::devices.clear();
+                DynCtx::sortedDevices.clear();
+                DynCtx::rows.clear();
+                DynCtx::scrollOffset = 0;
+                DynCtx::scrollInfoText.clear();
+            });
     }
 
     void Create(Window& window, UNUSED const std::string& monitor)
@@ -297,6 +377,21 @@ namespace BluetoothDevices
 
         WidgetHeader(*mainWidget);
         WidgetBody(*mainWidget);
+        mainWidget->AddOnDestroy(
+            []()
+            {
+                for (uint32_t id : DynCtx::pendingRequests)
+                {
+                    System::CancelBTRequest(id);
+                }
+                DynCtx::pendingRequests.clear();
+                // Opened by the bar, so gBar (and with it the discovery) keeps running after the close
+                if (DynCtx::scanning)
+                {
+                    DynCtx::scanning = false;
+                    System::StopBTScan();
+                }
+            });
 
         window.SetExclusive(false);
         Anchor anchor;
@@ -68,10 +68,10 @@ namespace CSS
         return true;
     }
 
-    void Load(const std::string& overrideConfigLocation)
-    {
-        sProvider = gtk_css_provider_new();
+    static std::string configLocation;
 
+    static bool LoadFromLocations(const std::string& overrideConfigLocation)
+    {
         std::vector<std::string> locations;
         const char* home = std::getenv("HOME");
 
@@ -122,7 +122,7 @@ namespace CSS
                 if (CompileAndLoadSCSS(dir + "/style.scss"))
                 {
                     LOG("SCSS found and loaded successfully!");
-                    return;
+                    return true;
                 }
                 else
                 {
@@ -134,10 +134,23 @@ namespace CSS
             if (LoadCSS(dir + "/style.css"))
             {
                 LOG("CSS found and loaded successfully!");
-                return;
+                return true;
             }
         }
-        ASSERT(false, "No CSS file found!");
+        return false;
+    }
+
+    void Load(const std::string& overrideConfigLocation)
+    {
+        sProvider = gtk_css_provider_new();
+        configLocation = overrideConfigLocation;
+        ASSERT(LoadFromLocations(configLocation), "No CSS file found!");
+    }
+
+    bool Reload()
+    {
+        // Loading into the same provider restyles all windows
+        return LoadFromLocations(configLocation);
     }
 
     GtkCssProvider* GetProvider()
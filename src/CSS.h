@@ -5,5 +5,7 @@
 namespace CSS
 {
     void Load(const std::string& overrideConfigLocation);
+    // Loads the style again from the same location. Returns false, if no style could be loaded.
+    bool Reload();
     GtkCssProvider* GetProvider();
 }
@@ -14,6 +14,7 @@
 #include <mutex>
 
 #include "Log.h"
+#include "WorkerPool.h"
 
 #define UNUSED [[maybe_unused]]
 
@@ -170,78 +171,64 @@ namespace Utils
     }
 }
 
-struct Process
-{
-    pid_t pid;
-};
-
-inline Process OpenProcess(const std::string& command)
-{
-    pid_t child = fork();
-    ASSERT(child != -1, "fork error");
-
-    if (child == 0)
-    {
-        // Child
-        system(command.c_str());
-        exit(0);
-    }
-    else
-    {
-        return {child};
-    }
-}
-
+// Only its address is used, as the coalescing key of the worker pool
 template<typename Data>
 struct AsyncAtomicContext
 {
-    std::atomic<bool> running = false;
-    std::mutex queueLock;
-    std::optional<Data> queue;
 };
 
-// Executes the callback function asynchronously, but only one at a time.
+// Executes the callback function asynchronously on the worker pool, but only one at a time.
 // Multiple requests at once are stored in a FIFO of size 1.
 // The context should point to a static reference.
 template<typename Data, typename Callback>
 inline void ExecuteAsyncAtomically(AsyncAtomicContext<Data>& context, const Callback& callback, const Data& data)
 {
-    // Update the queue
-    context.queueLock.lock();
-    context.queue = data;
-    context.queueLock.unlock();
+    WorkerPool::Submit((uintptr_t)&context,
+                       [callback, data]() mutable
+                       {
+                           callback(std::move(data));
+                       });
+}
+
+// Lock-free triple buffer for a single producer and a single consumer.
+// The producer fills GetWriteBuffer() completely and calls Publish(), the consumer always sees the newest published buffer.
+// Neither side ever blocks the other.
+template<typename Data>
+class TripleBuffer
+{
+public:
+    // Producer side
+    Data& GetWriteBuffer() { return m_Buffers[m_WriteIdx]; }
+    void Publish()
+    {
+        // Swap our freshly written buffer with the middle one and mark it as new for the consumer.
+        m_WriteIdx = m_Middle.exchange(m_WriteIdx | newDataBit, std::memory_order_acq_rel) & indexMask;
+    }
 
-    if (!context.running)
+    // Consumer side
+    const Data& GetReadBuffer()
     {
-        // Launch the thread
-        context.running = true;
-        std::thread(
-            [&, callback]()
-            {
-                while (true)
-                {
-                    context.queueLock.lock();
-                    if (!context.queue.has_value())
-                    {
-                        context.queueLock.unlock();
-                        break;
-                    }
-                    Data data = std::move(*context.queue);
-                    context.queue = {};
-                    context.queueLock.unlock();
-
-                    // Execute
-                    callback(std::move(data));
-                }
-                context.running = false;
-            })
-            .detach();
+        if (m_Middle.load(std::memory_order_relaxed) & newDataBit)
+        {
+            m_ReadIdx = m_Middle.exchange(m_ReadIdx, std::memory_order_acq_rel) & indexMask;
+        }
+        return m_Buffers[m_ReadIdx];
     }
-}
+
+private:
+    static constexpr uint8_t indexMask = 0x3;
+    static constexpr uint8_t newDataBit = 0x4;
+
+    Data m_Buffers[3]{};
+    uint8_t m_WriteIdx = 0;
+    uint8_t m_ReadIdx = 1;
+    std::atomic<uint8_t> m_Middle = 2;
+};
 
 // Plugins
 #include "Window.h"
-#define DL_VERSION 1
+// Bump, whenever the installed headers break plugins (2: OpenProcess and struct Process were replaced by Process::Run/RunShell)
+#define DL_VERSION 2
 
 #define DEFINE_PLUGIN(fun)                                              \
     extern "C" int32_t Plugin_GetVersion()                              \
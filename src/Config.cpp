@@ -211,6 +211,9 @@ void AddConfigVar(const std::string& propertyName, MapLike& propertyToSet, std::
 
 void Config::Load(const std::string& overrideConfigLocation)
 {
+    // Start from the defaults, in case this is a reload
+    config = Config();
+
     const char* xdgConfigHome = getenv("XDG_CONFIG_HOME");
     std::ifstream file;
     if (overrideConfigLocation != "")
@@ -289,6 +292,7 @@ void Config::Load(const std::string& overrideConfigLocation)
         AddConfigVar("AudioInput", config.audioInput, lineView, foundProperty);
         AddConfigVar("AudioRevealer", config.audioRevealer, lineView, foundProperty);
         AddConfigVar("AudioNumbers", config.audioNumbers, lineView, foundProperty);
+        AddConfigVar("AudioLevelMeter", config.audioLevelMeter, lineView, foundProperty);
         AddConfigVar("ManualFlyinAnimation", config.manualFlyinAnimation, lineView, foundProperty);
         AddConfigVar("NetworkWidget", config.networkWidget, lineView, foundProperty);
         AddConfigVar("WorkspaceScrollOnMonitor", config.workspaceScrollOnMonitor, lineView, foundProperty);
@@ -298,6 +302,7 @@ void Config::Load(const std::string& overrideConfigLocation)
         AddConfigVar("EnableSNI", config.enableSNI, lineView, foundProperty);
         AddConfigVar("SensorTooltips", config.sensorTooltips, lineView, foundProperty);
         AddConfigVar("IconsAlwaysUp", config.iconsAlwaysUp, lineView, foundProperty);
+        AddConfigVar("BTBattery", config.btBattery, lineView, foundProperty);
 
         AddConfigVar("MinUploadBytes", config.minUploadBytes, lineView, foundProperty);
         AddConfigVar("MaxUploadBytes", config.maxUploadBytes, lineView, foundProperty);
@@ -310,8 +315,11 @@ void Config::Load(const std::string& overrideConfigLocation)
         AddConfigVar("NumWorkspaces", config.numWorkspaces, lineView, foundProperty);
         AddConfigVar("AudioScrollSpeed", config.audioScrollSpeed, lineView, foundProperty);
         AddConfigVar("SensorSize", config.sensorSize, lineView, foundProperty);
+        AddConfigVar("CPUCoreSize", config.cpuCoreSize, lineView, foundProperty);
         AddConfigVar("NetworkIconSize", config.networkIconSize, lineView, foundProperty);
         AddConfigVar("BatteryWarnThreshold", config.batteryWarnThreshold, lineView, foundProperty);
+        AddConfigVar("BTMaxVisibleDevices", config.btMaxVisibleDevices, lineView, foundProperty);
+        AddConfigVar("MixerMaxHeight", config.mixerMaxHeight, lineView, foundProperty);
 
         AddConfigVar("AudioMinVolume", config.audioMinVolume, lineView, foundProperty);
         AddConfigVar("AudioMaxVolume", config.audioMaxVolume, lineView, foundProperty);
@@ -322,6 +330,8 @@ void Config::Load(const std::string& overrideConfigLocation)
         AddConfigVar("SNIPaddingTop", config.sniPaddingTop, lineView, foundProperty);
         AddConfigVar("SNIIconName", config.sniIconNames, lineView, foundProperty);
         AddConfigVar("SNIDisabled", config.sniDisabled, lineView, foundProperty);
+
+        AddConfigVar("CustomWidget", config.customWidgets, lineView, foundProperty);
         // Modern map syntax
         AddConfigVar("WorkspaceSymbol", config.workspaceSymbols, lineView, foundProperty);
 
@@ -60,6 +60,7 @@ public:
     bool audioRevealer = false;
     bool audioInput = false;
     bool audioNumbers = false;         // Affects both audio sliders
+    bool audioLevelMeter = false;      // Show the peak level of the default sink/source next to the audio widgets
     bool manualFlyinAnimation = false; // Do the flyin animation via margin updating
     bool networkWidget = true;
     bool workspaceScrollOnMonitor = true; // Scroll through workspaces on monitor instead of all
@@ -69,6 +70,7 @@ public:
     bool enableSNI = true;                // Enable tray icon
     bool sensorTooltips = false;          // Use tooltips instead of sliders for the sensors
     bool iconsAlwaysUp = false;           // Force icons to always point upwards in sidebar mode
+    bool btBattery = false;               // Show the battery percentage of connected bluetooth devices next to their icon
 
     // Controls for color progression of the network widget
     uint32_t minUploadBytes = 0;                  // Bottom limit of the network widgets upload. Everything below it is considered "under"
@@ -82,8 +84,11 @@ public:
     uint32_t maxTitleLength = 30;          // Maximum chars of the title widget. Longer titles will be shortened
     uint32_t numWorkspaces = 9;            // How many workspaces to display
     uint32_t sensorSize = 24;              // The size of the circular sensors
+    uint32_t cpuCoreSize = 3;              // The size of a single core in the CPUCores widget
     uint32_t networkIconSize = 24;         // The size of the two network arrows
     uint32_t batteryWarnThreshold = 20;    // Threshold for color change when on battery
+    uint32_t btMaxVisibleDevices = 10;     // How many devices the bluetooth widget shows at once, the rest is reached by scrolling
+    uint32_t mixerMaxHeight = 600;         // Height of the mixer's stream list, after which it scrolls
 
     char location = 'T'; // The Location of the bar. Can be L,R,T,B
 
@@ -93,6 +98,9 @@ public:
     std::unordered_map<std::string, std::string> sniIconNames;
     std::unordered_map<std::string, bool> sniDisabled;
 
+    // CustomWidget: [name], [interval in seconds | continuous], [command]
+    std::unordered_map<std::string, std::pair<std::string, std::string>> customWidgets;
+
     // Only affects outputs (i.e.: speakers, not microphones). This remaps the range of the volume; In percent
     double audioMinVolume = 0.f;   // Map the minimum volume to this value
     double audioMaxVolume = 100.f; // Map the maximum volume to this value
@@ -136,6 +144,8 @@ public:
 
     bool hasNet = true;
 
+    bool hasBattery = true;
+
     bool hasPackagesScript = true;
 
     static RuntimeConfig& Get();
@@ -0,0 +1,336 @@
+#include "Control.h"
+#include "Common.h"
+
+#include <glib.h>
+#include <glib-unix.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace Control
+{
+    // Longer requests are a broken client, drop it
+    constexpr size_t maxRequestSize = 64 * 1024;
+
+    struct Client
+    {
+        int fd;
+        guint source;
+        std::string buffer;
+    };
+
+    static int listenFd = -1;
+    static guint listenSource = 0;
+    static std::string socketPath;
+    static std::vector<Client*> clients;
+    static std::unordered_map<std::string, Handler> handlers;
+
+    static std::string GetSocketDir()
+    {
+        // Falls back to the cache dir, if XDG_RUNTIME_DIR is not set
+        return std::string(g_get_user_runtime_dir()) + "/gBar";
+    }
+
+    static bool FillAddress(const std::string& path, sockaddr_un& addr)
+    {
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path))
+        {
+            LOG("Control: Socket path " << path << " is too long!");
+            return false;
+        }
+        memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+
+    static int ConnectTo(const std::string& path)
+    {
+        sockaddr_un addr;
+        if (!FillAddress(path, addr))
+            return -1;
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            return -1;
+        if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+        {
+            int connectErrno = errno;
+            close(fd);
+            errno = connectErrno;
+            return -1;
+        }
+        return fd;
+    }
+
+    static std::string Execute(std::string_view request)
+    {
+        size_t nameEnd = request.find(' ');
+        std::string name = std::string(request.substr(0, nameEnd));
+        std::string_view args = nameEnd == std::string_view::npos ? std::string_view() : request.substr(nameEnd + 1);
+
+        auto it = handlers.find(name);
+        if (it == handlers.end())
+        {
+            return "unknown command \"" + name + "\"";
+        }
+        // Copy, since the handler may replace itself (e.g. reload-config)
+        Handler handler = it->second;
+        return handler(args);
+    }
+
+    static void CloseClient(Client* client)
+    {
+        clients.erase(std::remove(clients.begin(), clients.end(), client), clients.end());
+        close(client->fd);
+        delete client;
+    }
+
+    static gboolean OnClientEvent(gint fd, GIOCondition, gpointer data)
+    {
+        Client* client = (Client*)data;
+        char buf[4096];
+        while (true)
+        {
+            ssize_t bytesRead = read(fd, buf, sizeof(buf));
+            if (bytesRead > 0)
+            {
+                client->buffer.append(buf, bytesRead);
+                continue;
+            }
+            if (bytesRead < 0 && errno == EINTR)
+                continue;
+            if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+
+            // EOF or error. Execute a last request without a trailing newline, then close.
+            if (bytesRead == 0 && !client->buffer.empty())
+            {
+                client->buffer += '\n';
+            }
+            else
+            {
+                CloseClient(client);
+                return G_SOURCE_REMOVE;
+            }
+            break;
+        }
+
+        size_t lineEnd;
+        while ((lineEnd = client->buffer.find('\n')) != std::string::npos)
+        {
+            std::string request = client->buffer.substr(0, lineEnd);
+            client->buffer.erase(0, lineEnd + 1);
+            if (request.empty())
+                continue;
+
+            std::string error = Execute(request);
+            std::string reply = error.empty() ? "ok\n" : "error: " + error + "\n";
+            // Replies are tiny, a client that doesn't read them is dropped
+            if (send(fd, reply.data(), reply.size(), MSG_NOSIGNAL | MSG_DONTWAIT) != (ssize_t)reply.size())
+            {
+                CloseClient(client);
+                return G_SOURCE_REMOVE;
+            }
+        }
+
+        if (client->buffer.size() > maxRequestSize)
+        {
+            LOG("Control: Request too long, dropping client");
+            CloseClient(client);
+            return G_SOURCE_REMOVE;
+        }
+        return G_SOURCE_CONTINUE;
+    }
+
+    static gboolean OnAccept(gint, GIOCondition, gpointer)
+    {
+        while (true)
+        {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    LOG("Control: accept failed: " << strerror(errno));
+                }
+                break;
+            }
+            Client* client = new Client{fd, 0, {}};
+            client->source = g_unix_fd_add(fd, (GIOCondition)(G_IO_IN | G_IO_HUP | G_IO_ERR), OnClientEvent, client);
+            clients.push_back(client);
+        }
+        return G_SOURCE_CONTINUE;
+    }
+
+    void Start(const std::string& monitor)
+    {
+        std::string dir = GetSocketDir();
+        if (mkdir(dir.c_str(), 0700) < 0 && errno != EEXIST)
+        {
+            LOG("Control: Cannot create " << dir << ": " << strerror(errno));
+            return;
+        }
+
+        std::string path = dir + "/" + monitor + ".sock";
+        sockaddr_un addr;
+        if (!FillAddress(path, addr))
+            return;
+
+        // A socket nobody listens on is left over from a crash
+        int existing = ConnectTo(path);
+        if (existing >= 0)
+        {
+            close(existing);
+            LOG("Control: Another bar is already listening on " << path << ", not starting the control socket");
+            return;
+        }
+        unlink(path.c_str());
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0 || bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 16) < 0)
+        {
+            LOG("Control: Cannot listen on " << path << ": " << strerror(errno));
+            if (listenFd >= 0)
+                close(listenFd);
+            listenFd = -1;
+            return;
+        }
+        socketPath = path;
+        listenSource = g_unix_fd_add(listenFd, G_IO_IN, OnAccept, nullptr);
+        LOG("Control: Listening on " << socketPath);
+    }
+
+    void AddCommand(const std::string& name, Handler&& handler)
+    {
+        handlers[name] = std::move(handler);
+    }
+
+    // Sends the request and waits for the reply. Returns false, if the bar couldn't be reached.
+    static bool Exchange(const std::string& path, const std::string& request, std::string& reply)
+    {
+        int fd = ConnectTo(path);
+        if (fd < 0)
+            return false;
+        std::string line = request + "\n";
+        if (send(fd, line.data(), line.size(), MSG_NOSIGNAL) != (ssize_t)line.size())
+        {
+            int err = errno;
+            close(fd);
+            errno = err;
+            return false;
+        }
+        shutdown(fd, SHUT_WR);
+
+        char buf[512];
+        ssize_t bytesRead;
+        while ((bytesRead = read(fd, buf, sizeof(buf))) > 0)
+        {
+            reply.append(buf, bytesRead);
+        }
+        close(fd);
+        return true;
+    }
+
+    static int SendTo(const std::string& path, const std::string& request)
+    {
+        std::string reply;
+        if (!Exchange(path, request, reply))
+        {
+            LOG("Cannot send to " << path << ": " << strerror(errno));
+            return 1;
+        }
+        if (reply.rfind("ok", 0) == 0)
+            return 0;
+        if (!reply.empty() && reply.back() == '\n')
+            reply.pop_back();
+        LOG(path << ": " << (reply.empty() ? "No reply" : reply));
+        return 1;
+    }
+
+    // Sockets of all running bars. Prints an error, if there are none.
+    static std::vector<std::string> FindSockets()
+    {
+        std::string dir = GetSocketDir();
+        DIR* socketDir = opendir(dir.c_str());
+        if (!socketDir)
+        {
+            LOG("No running bar found (" << dir << " doesn't exist)");
+            return {};
+        }
+        std::vector<std::string> sockets;
+        while (dirent* entry = readdir(socketDir))
+        {
+            std::string_view name = entry->d_name;
+            if (name.size() <= 5 || name.substr(name.size() - 5) != ".sock")
+                continue;
+            sockets.push_back(dir + "/" + std::string(name));
+        }
+        closedir(socketDir);
+        if (sockets.empty())
+        {
+            LOG("No running bar found in " << dir);
+        }
+        return sockets;
+    }
+
+    int Send(const std::string& monitor, const std::string& request)
+    {
+        if (!monitor.empty())
+        {
+            return SendTo(GetSocketDir() + "/" + monitor + ".sock", request);
+        }
+
+        std::vector<std::string> sockets = FindSockets();
+        if (sockets.empty())
+            return 1;
+        int result = 0;
+        for (auto& path : sockets)
+        {
+            result |= SendTo(path, request);
+        }
+        return result;
+    }
+
+    int SendToFocused(const std::string& request)
+    {
+        std::vector<std::string> sockets = FindSockets();
+        if (sockets.empty())
+            return 1;
+        for (auto& path : sockets)
+        {
+            // Bars, that don't answer, are left over from a crash
+            std::string reply;
+            if (Exchange(path, std::string(focusedCommand), reply) && reply.rfind("ok", 0) == 0)
+                return SendTo(path, request);
+        }
+        LOG("No bar is on the focused monitor, use --monitor to choose one");
+        return 1;
+    }
+
+    void Shutdown()
+    {
+        while (!clients.empty())
+        {
+            g_source_remove(clients.back()->source);
+            CloseClient(clients.back());
+        }
+        if (listenFd >= 0)
+        {
+            g_source_remove(listenSource);
+            close(listenFd);
+            listenFd = -1;
+            unlink(socketPath.c_str());
+        }
+        handlers.clear();
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Unix socket to control a running bar, e.g. from keybindings or scripts. Each bar listens on $XDG_RUNTIME_DIR/gBar/<monitor>.sock.
+// A request is one line: "<command> <arguments>". Each request is answered with "ok" or "error: <message>".
+// A connection may send any number of requests, so scripts can keep it open.
+namespace Control
+{
+    // Returns an empty string on success, or the error message
+    using Handler = std::function<std::string(std::string_view args)>;
+
+    // Starts listening on the socket of the monitor. Commands are executed on the main thread.
+    void Start(const std::string& monitor);
+    // Replaces an already registered command with the same name
+    void AddCommand(const std::string& name, Handler&& handler);
+
+    // Each bar answers this with "ok", if it is on the monitor with the active window (see Wayland::GetFocusedMonitor()).
+    // The bar registers it, since only it knows its monitor.
+    constexpr std::string_view focusedCommand = "focused";
+
+    // Client side: Sends a single request to the bar on the monitor, or to all running bars if the monitor is empty.
+    // Prints errors and returns the exit code for the process.
+    int Send(const std::string& monitor, const std::string& request);
+    // Client side: Sends a single request only to the bar, that answers focusedCommand. Fails, if none does.
+    int SendToFocused(const std::string& request);
+
+    void Shutdown();
+}
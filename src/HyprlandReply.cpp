@@ -0,0 +1,62 @@
+#include "HyprlandReply.h"
+#include "JSON.h"
+
+namespace HyprlandReply
+{
+    bool ParseJSON(std::string_view reply, Model& model)
+    {
+        // The reply are the two arrays after each other
+        JSON::Tokenizer tokenizer(reply);
+
+        auto parseWorkspace = [&model](JSON::Tokenizer& tokenizer)
+        {
+            int64_t wsId = 0;
+            std::string_view mon;
+            bool valid = JSON::ForEachMember(tokenizer,
+                                             [&](std::string_view key, JSON::Tokenizer& tokenizer)
+                                             {
+                                                 if (key == "id")
+                                                     return JSON::ReadInt(tokenizer, wsId);
+                                                 if (key == "monitor")
+                                                     return JSON::ReadString(tokenizer, mon);
+                                                 return tokenizer.Skip();
+                                             });
+            model.workspaceMonitors[wsId] = mon;
+            return valid;
+        };
+
+        auto parseMonitor = [&model](JSON::Tokenizer& tokenizer)
+        {
+            std::string_view mon;
+            int64_t wsId = 0;
+            bool focused = false;
+            bool valid = JSON::ForEachMember(tokenizer,
+                                             [&](std::string_view key, JSON::Tokenizer& tokenizer)
+                                             {
+                                                 if (key == "name")
+                                                     return JSON::ReadString(tokenizer, mon);
+                                                 if (key == "focused")
+                                                     return JSON::ReadBool(tokenizer, focused);
+                                                 if (key == "activeWorkspace")
+                                                 {
+                                                     return JSON::ForEachMember(tokenizer,
+                                                                                [&](std::string_view key, JSON::Tokenizer& tokenizer)
+                                                                                {
+                                                                                    if (key == "id")
+                                                                                        return JSON::ReadInt(tokenizer, wsId);
+                                                                                    return tokenizer.Skip();
+                                                                                });
+                                                 }
+                                                 return tokenizer.Skip();
+                                             });
+            model.activeWorkspaces[std::string(mon)] = wsId;
+            if (focused)
+            {
+                model.focusedMonitor = mon;
+            }
+            return valid;
+        };
+
+        return JSON::ForEachElement(tokenizer, parseWorkspace) && JSON::ForEachElement(tokenizer, parseMonitor);
+    }
+}
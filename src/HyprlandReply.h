@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Parser for Hyprland's IPC replies. Kept apart from Workspaces.cpp, so it can be benchmarked with recorded replies (see bench/Bench.cpp).
+namespace HyprlandReply
+{
+    // Hyprland's workspaces and monitors, as far as the bar needs them
+    struct Model
+    {
+        std::unordered_map<int32_t, std::string> workspaceMonitors;
+        std::unordered_map<std::string, int32_t> activeWorkspaces;
+        std::string focusedMonitor;
+    };
+
+    // Parses the reply of a single batched "[[BATCH]]j/workspaces;j/monitors" request. Returns false, if the reply couldn't be parsed.
+    bool ParseJSON(std::string_view reply, Model& model);
+}
@@ -0,0 +1,213 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+
+// Minimal streaming JSON tokenizer over a string_view. Nothing is copied or allocated, strings are returned as views into the input
+// (Escape sequences are not decoded). Multiple top-level values after each other (e.g. Hyprland batch replies) are read one after another.
+namespace JSON
+{
+    enum class TokenType
+    {
+        ObjectBegin,
+        ObjectEnd,
+        ArrayBegin,
+        ArrayEnd,
+        String,
+        Number,
+        True,
+        False,
+        Null,
+        End,
+        Error
+    };
+
+    struct Token
+    {
+        TokenType type;
+        // Contents of strings (without quotes) and numbers
+        std::string_view value;
+    };
+
+    class Tokenizer
+    {
+    public:
+        Tokenizer(std::string_view json) : m_Json(json) {}
+
+        Token Next()
+        {
+            // Separators carry no information for a streaming reader, so skip them together with whitespace
+            while (m_Pos < m_Json.size() && IsSeparator(m_Json[m_Pos]))
+            {
+                m_Pos++;
+            }
+            if (m_Pos == m_Json.size())
+            {
+                return {TokenType::End, {}};
+            }
+
+            char c = m_Json[m_Pos];
+            switch (c)
+            {
+            case '{': m_Pos++; return {TokenType::ObjectBegin, {}};
+            case '}': m_Pos++; return {TokenType::ObjectEnd, {}};
+            case '[': m_Pos++; return {TokenType::ArrayBegin, {}};
+            case ']': m_Pos++; return {TokenType::ArrayEnd, {}};
+            case '"': return NextString();
+            case 't': return NextLiteral("true", TokenType::True);
+            case 'f': return NextLiteral("false", TokenType::False);
+            case 'n': return NextLiteral("null", TokenType::Null);
+            default:
+                if (c == '-' || (c >= '0' && c <= '9'))
+                {
+                    return NextNumber();
+                }
+                return {TokenType::Error, {}};
+            }
+        }
+
+        Token Peek()
+        {
+            size_t pos = m_Pos;
+            Token token = Next();
+            m_Pos = pos;
+            return token;
+        }
+
+        // Skips the next value, including everything nested in it
+        bool Skip()
+        {
+            uint32_t depth = 0;
+            do
+            {
+                Token token = Next();
+                switch (token.type)
+                {
+                case TokenType::ObjectBegin:
+                case TokenType::ArrayBegin: depth++; break;
+                case TokenType::ObjectEnd:
+                case TokenType::ArrayEnd:
+                    if (depth == 0)
+                        return false;
+                    depth--;
+                    break;
+                case TokenType::End:
+                case TokenType::Error: return false;
+                default: break;
+                }
+            } while (depth > 0);
+            return true;
+        }
+
+    private:
+        static bool IsSeparator(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == ',' || c == ':'; }
+
+        Token NextString()
+        {
+            size_t begin = ++m_Pos;
+            while (m_Pos < m_Json.size() && m_Json[m_Pos] != '"')
+            {
+                // Skip the escaped char, so \" doesn't end the string
+                m_Pos += m_Json[m_Pos] == '\\' ? 2 : 1;
+            }
+            if (m_Pos >= m_Json.size())
+            {
+                return {TokenType::Error, {}};
+            }
+            return {TokenType::String, m_Json.substr(begin, m_Pos++ - begin)};
+        }
+
+        Token NextNumber()
+        {
+            size_t begin = m_Pos;
+            while (m_Pos < m_Json.size() && !IsSeparator(m_Json[m_Pos]) && m_Json[m_Pos] != '}' && m_Json[m_Pos] != ']')
+            {
+                m_Pos++;
+            }
+            return {TokenType::Number, m_Json.substr(begin, m_Pos - begin)};
+        }
+
+        Token NextLiteral(std::string_view literal, TokenType type)
+        {
+            if (m_Json.substr(m_Pos, literal.size()) != literal)
+            {
+                return {TokenType::Error, {}};
+            }
+            m_Pos += literal.size();
+            return {type, {}};
+        }
+
+        std::string_view m_Json;
+        size_t m_Pos = 0;
+    };
+
+    // Calls fn(key, tokenizer) for each member of the object starting at the next token. fn has to consume the value and return false on error.
+    template<typename Fn>
+    inline bool ForEachMember(Tokenizer& tokenizer, Fn&& fn)
+    {
+        if (tokenizer.Next().type != TokenType::ObjectBegin)
+        {
+            return false;
+        }
+        while (true)
+        {
+            Token key = tokenizer.Next();
+            if (key.type == TokenType::ObjectEnd)
+            {
+                return true;
+            }
+            if (key.type != TokenType::String || !fn(key.value, tokenizer))
+            {
+                return false;
+            }
+        }
+    }
+
+    // Calls fn(tokenizer) for each element of the array starting at the next token. fn has to consume the element and return false on error.
+    template<typename Fn>
+    inline bool ForEachElement(Tokenizer& tokenizer, Fn&& fn)
+    {
+        if (tokenizer.Next().type != TokenType::ArrayBegin)
+        {
+            return false;
+        }
+        while (true)
+        {
+            TokenType next = tokenizer.Peek().type;
+            if (next == TokenType::ArrayEnd)
+            {
+                tokenizer.Next();
+                return true;
+            }
+            if (next == TokenType::End || next == TokenType::Error || !fn(tokenizer))
+            {
+                return false;
+            }
+        }
+    }
+
+    inline bool ReadInt(Tokenizer& tokenizer, int64_t& out)
+    {
+        Token token = tokenizer.Next();
+        if (token.type != TokenType::Number)
+        {
+            return false;
+        }
+        auto res = std::from_chars(token.value.data(), token.value.data() + token.value.size(), out);
+        return res.ec == std::errc();
+    }
+
+    inline bool ReadString(Tokenizer& tokenizer, std::string_view& out)
+    {
+        Token token = tokenizer.Next();
+        out = token.value;
+        return token.type == TokenType::String;
+    }
+
+    inline bool ReadBool(Tokenizer& tokenizer, bool& out)
+    {
+        Token token = tokenizer.Next();
+        out = token.type == TokenType::True;
+        return token.type == TokenType::True || token.type == TokenType::False;
+    }
+}
@@ -2,16 +2,24 @@
 #include "Common.h"
 
 #include <fstream>
+#include <mutex>
 
 namespace Logging
 {
     static std::ofstream logFile;
+    // The sampler, the worker pool and the PulseAudio thread log too
+    static std::mutex logMutex;
 
     void Init()
     {
         pid_t pid = getpid();
-        logFile = std::ofstream("/tmp/gBar-" + std::to_string(pid) + ".log");
-        if (!logFile.is_open())
+        bool opened;
+        {
+            std::scoped_lock<std::mutex> lock(logMutex);
+            logFile = std::ofstream("/tmp/gBar-" + std::to_string(pid) + ".log");
+            opened = logFile.is_open();
+        }
+        if (!opened)
         {
             LOG("Cannot open logfile(/tmp/gBar-" << pid << ".log)");
         }
@@ -19,12 +27,14 @@ namespace Logging
 
     void Log(const std::string& str)
     {
+        std::scoped_lock<std::mutex> lock(logMutex);
         if (logFile.is_open())
             logFile << str << std::endl;
     }
 
     void Shutdown()
     {
+        std::scoped_lock<std::mutex> lock(logMutex);
         logFile.close();
     }
 }
@@ -0,0 +1,98 @@
+#include "MainQueue.h"
+#include "Common.h"
+
+#include <glib.h>
+
+#include <atomic>
+
+namespace MainQueue
+{
+    // Intrusive stack, newest first. Producers push with a CAS, the main thread takes the whole stack at once, so there is no ABA problem.
+    static std::atomic<Node*> head = nullptr;
+    static std::atomic<GSource*> source = nullptr;
+
+    static void Wakeup()
+    {
+        if (GSource* src = source.load(std::memory_order_acquire))
+        {
+            // Wakes up the main context, if called from another thread
+            g_source_set_ready_time(src, 0);
+        }
+    }
+
+    static void FreeList(Node* list)
+    {
+        while (list)
+        {
+            Node* next = list->next;
+            delete list;
+            list = next;
+        }
+    }
+
+    static gboolean Dispatch(GSource* src, GSourceFunc, gpointer)
+    {
+        // Before taking the stack, so a push right after it wakes us up again
+        g_source_set_ready_time(src, -1);
+        Node* list = head.exchange(nullptr, std::memory_order_acquire);
+
+        // Reverse into posting order
+        Node* ordered = nullptr;
+        while (list)
+        {
+            Node* next = list->next;
+            list->next = ordered;
+            ordered = list;
+            list = next;
+        }
+
+        // Work posted from here on runs in the next batch
+        while (ordered)
+        {
+            Node* next = ordered->next;
+            ordered->Run();
+            delete ordered;
+            ordered = next;
+        }
+        return G_SOURCE_CONTINUE;
+    }
+
+    static GSourceFuncs sourceFuncs = {nullptr, nullptr, Dispatch, nullptr, nullptr, nullptr};
+
+    void Push(Node* node)
+    {
+        Node* prev = head.load(std::memory_order_relaxed);
+        do
+        {
+            node->next = prev;
+        } while (!head.compare_exchange_weak(prev, node, std::memory_order_release, std::memory_order_relaxed));
+
+        // Only the first push into an empty stack needs to wake up the main thread, the rest is picked up by the same dispatch
+        if (!prev)
+        {
+            Wakeup();
+        }
+    }
+
+    void Init()
+    {
+        GSource* src = g_source_new(&sourceFuncs, sizeof(GSource));
+        g_source_set_name(src, "MainQueue");
+        g_source_attach(src, nullptr);
+        source.store(src, std::memory_order_release);
+        if (head.load(std::memory_order_acquire))
+        {
+            Wakeup();
+        }
+    }
+
+    void Shutdown()
+    {
+        if (GSource* src = source.exchange(nullptr))
+        {
+            g_source_destroy(src);
+            g_source_unref(src);
+        }
+        FreeList(head.exchange(nullptr));
+    }
+}
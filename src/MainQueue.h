@@ -0,0 +1,38 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+
+// Hands work from other threads (audio threads, the worker pool) back to the main thread, where GTK may be touched.
+// Posting is lock-free and never blocks. Everything posted is run in order by a single GSource, in one batch per main loop iteration.
+namespace MainQueue
+{
+    struct Node
+    {
+        virtual ~Node() = default;
+        virtual void Run() = 0;
+
+        Node* next = nullptr;
+    };
+
+    // Any thread. Takes ownership of the node.
+    void Push(Node* node);
+
+    // Work posted before Init() runs once the main loop starts
+    void Init();
+    // Drops everything, that hasn't run yet. Other threads must not post anymore.
+    void Shutdown();
+}
+
+// Runs fn on the main thread. Can be called from any thread.
+template<typename Fn>
+inline void PostToMain(Fn&& fn)
+{
+    struct FnNode : MainQueue::Node
+    {
+        std::decay_t<Fn> fn;
+
+        FnNode(Fn&& fn) : fn(std::forward<Fn>(fn)) {}
+        void Run() override { fn(); }
+    };
+    MainQueue::Push(new FnNode(std::forward<Fn>(fn)));
+}
@@ -0,0 +1,243 @@
+#include "Mixer.h"
+#include "System.h"
+#include "Config.h"
+
+#include <unordered_map>
+
+namespace Mixer
+{
+    namespace DynCtx
+    {
+        struct Row
+        {
+            Box* box;
+            Button* name;
+            Slider* slider;
+            Button* mute;
+            double volume = -1;
+            bool muted = false;
+        };
+
+        Window* win;
+        // One box per System::AudioStreamType
+        Box* sections[3];
+        // Rows stay alive while their stream exists, so events only touch the widgets, that changed
+        std::unordered_map<uint64_t, Row> rows;
+        // Set while applying changes from the server, so the sliders don't send them back
+        bool applying = false;
+
+        uint64_t RowKey(System::AudioStreamType type, uint32_t index)
+        {
+            return ((uint64_t)type << 32) | index;
+        }
+        uint64_t RowKey(const System::AudioStream& stream)
+        {
+            return RowKey(stream.type, stream.index);
+        }
+
+        std::string MuteIcon(const System::AudioStream& stream)
+        {
+            if (stream.type == System::AudioStreamType::Source)
+            {
+                return stream.muted ? Config::Get().micMutedIcon : Config::Get().micHighIcon;
+            }
+            return stream.muted ? Config::Get().speakerMutedIcon : Config::Get().speakerHighIcon;
+        }
+
+        Row& CreateRow(const System::AudioStream& stream)
+        {
+            System::AudioStreamType type = stream.type;
+            uint32_t index = stream.index;
+            Row row;
+
+            auto box = Widget::Create<Box>();
+            box->SetClass("mixer-row");
+            box->SetSpacing({8, false});
+            row.box = box.get();
+
+            auto name = Widget::Create<Button>();
+            name->SetClass("mixer-name");
+            name->SetHorizontalTransform({200, false, Alignment::Left});
+            if (type != System::AudioStreamType::SinkInput)
+            {
+                name->OnClick(
+                    [type, index](Button&)
+                    {
+                        System::SetDefaultAudioStream(type, index);
+                    });
+            }
+            row.name = name.get();
+
+            auto slider = Widget::Create<Slider>();
+            slider->SetClass("mixer-volume");
+            slider->SetOrientation(Orientation::Horizontal);
+            slider->SetHorizontalTransform({100, true, Alignment::Fill});
+            slider->SetRange({0, 1, 0.01});
+            slider->OnValueChange(
+                [type, index](Slider&, double value)
+                {
+                    if (!applying)
+                        System::SetAudioStreamVolume(type, index, value);
+                });
+            row.slider = slider.get();
+
+            auto mute = Widget::Create<Button>();
+            mute->SetClass("mixer-mute");
+            mute->OnClick(
+                [type, index](Button&)
+                {
+                    auto it = rows.find(RowKey(type, index));
+                    if (it != rows.end())
+                        System::SetAudioStreamMuted(type, index, !it->second.muted);
+                });
+            row.mute = mute.get();
+
+            box->AddChild(std::move(name));
+            box->AddChild(std::move(slider));
+            box->AddChild(std::move(mute));
+            sections[(size_t)type]->AddChild(std::move(box));
+
+            return rows.emplace(RowKey(stream), row).first->second;
+        }
+
+        void OnStreamChange(const System::AudioStream& stream, bool removed)
+        {
+            auto it = rows.find(RowKey(stream));
+            if (removed)
+            {
+                if (it != rows.end())
+                {
+                    sections[(size_t)stream.type]->RemoveChild(it->second.box);
+                    rows.erase(it);
+                }
+                return;
+            }
+
+            Row& row = it != rows.end() ? it->second : CreateRow(stream);
+            row.name->SetText(stream.description);
+            if (stream.isDefault)
+                row.name->AddClass("default");
+            else
+                row.name->RemoveClass("default");
+
+            if (stream.volume != row.volume)
+            {
+                row.volume = stream.volume;
+                applying = true;
+                row.slider->SetValue(stream.volume);
+                applying = false;
+            }
+
+            row.muted = stream.muted;
+            row.mute->SetText(MuteIcon(stream));
+            if (stream.muted)
+                row.box->AddClass("muted");
+            else
+                row.box->RemoveClass("muted");
+        }
+
+        void Close(Button&)
+        {
+            win->Close();
+        }
+    }
+
+    void WidgetHeader(Widget& parentWidget)
+    {
+        auto headerBox = Widget::Create<Box>();
+        headerBox->SetClass("mixer-header-box");
+        {
+            auto headerText = Widget::Create<Text>();
+            headerText->SetText(Config::Get().speakerHighIcon + " Mixer");
+            headerText->SetHorizontalTransform({-1, true, Alignment::Left});
+            headerBox->AddChild(std::move(headerText));
+
+            auto headerClose = Widget::Create<Button>();
+            headerClose->SetText("");
+            headerClose->SetClass("mixer-close");
+            headerClose->OnClick(DynCtx::Close);
+            headerBox->AddChild(std::move(headerClose));
+        }
+        parentWidget.AddChild(std::move(headerBox));
+    }
+
+    void WidgetSection(Widget& parentWidget, System::AudioStreamType type, const std::string& title)
+    {
+        auto titleText = Widget::Create<Text>();
+        titleText->SetClass("mixer-section-title");
+        titleText->SetHorizontalTransform({-1, true, Alignment::Left});
+        titleText->SetText(title);
+        parentWidget.AddChild(std::move(titleText));
+
+        auto sectionBox = Widget::Create<Box>();
+        sectionBox->SetOrientation(Orientation::Vertical);
+        sectionBox->SetClass("mixer-body-box");
+        DynCtx::sections[(size_t)type] = sectionBox.get();
+        parentWidget.AddChild(std::move(sectionBox));
+    }
+
+    void Create(Window& window, UNUSED const std::string& monitor)
+    {
+        DynCtx::win = &window;
+        auto mainWidget = Widget::Create<Box>();
+        mainWidget->SetSpacing({8, false});
+        mainWidget->SetOrientation(Orientation::Vertical);
+        mainWidget->SetVerticalTransform({32, true, Alignment::Fill});
+        mainWidget->SetClass("mixer-bg");
+
+        WidgetHeader(*mainWidget);
+        // Lots of application streams would otherwise grow the popup off screen
+        auto scrollingArea = Widget::Create<ScrollingArea>();
+        scrollingArea->SetMaxHeight(Config::Get().mixerMaxHeight);
+        {
+            auto sectionsBox = Widget::Create<Box>();
+            sectionsBox->SetSpacing({8, false});
+            sectionsBox->SetOrientation(Orientation::Vertical);
+            WidgetSection(*sectionsBox, System::AudioStreamType::Sink, "Output");
+            WidgetSection(*sectionsBox, System::AudioStreamType::Source, "Input");
+            WidgetSection(*sectionsBox, System::AudioStreamType::SinkInput, "Applications");
+            scrollingArea->AddChild(std::move(sectionsBox));
+        }
+        mainWidget->AddChild(std::move(scrollingArea));
+
+        uint32_t callbackId = System::AddAudioStreamCallback(DynCtx::OnStreamChange);
+        mainWidget->AddOnDestroy(
+            [callbackId]()
+            {
+                System::RemoveAudioStreamCallback(callbackId);
+                DynCtx::rows.clear();
+            });
+
+        window.SetExclusive(false);
+        Anchor anchor;
+        Anchor marginAnchor;
+        switch (Config::Get().location)
+        {
+        case 'T':
+            anchor = Anchor::Right | Anchor::Top;
+            marginAnchor = Anchor::Top;
+            break;
+        case 'B':
+            anchor = Anchor::Bottom | Anchor::Right;
+            marginAnchor = Anchor::Bottom;
+            break;
+        case 'L':
+            anchor = Anchor::Left | Anchor::Bottom;
+            marginAnchor = Anchor::Left;
+            window.SetMargin(Anchor::Bottom, 150);
+            break;
+        case 'R':
+            anchor = Anchor::Right | Anchor::Bottom;
+            marginAnchor = Anchor::Right;
+            window.SetMargin(Anchor::Bottom, 150);
+            break;
+        default:
+            LOG("Invalid location char \"" << Config::Get().location << "\"!");
+            anchor = Anchor::Right | Anchor::Top;
+            marginAnchor = Anchor::Top;
+        }
+        window.SetMargin(marginAnchor, 8);
+        window.SetAnchor(anchor);
+        window.SetMainWidget(std::move(mainWidget));
+    }
+}
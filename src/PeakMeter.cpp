@@ -0,0 +1,250 @@
+#include "PeakMeter.h"
+#include "Common.h"
+#include "MainQueue.h"
+
+#include <pulse/pulseaudio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace PeakMeter
+{
+    // Peaks per second. With PA_STREAM_PEAK_DETECT the server sends the peak of each 1/rate interval instead of the samples.
+    constexpr uint32_t rate = 25;
+    // Levels are delivered in these steps, so silence and tiny fluctuations don't cause redraws
+    constexpr uint32_t levelSteps = 50;
+
+    enum Channel
+    {
+        Sink,
+        Source,
+        ChannelCount
+    };
+    static const char* channelDevices[ChannelCount] = {"@DEFAULT_MONITOR@", "@DEFAULT_SOURCE@"};
+
+    // Owned by the PulseAudio thread while it runs
+    static pa_threaded_mainloop* mainLoop;
+    static pa_context* context;
+    static pa_stream* streams[ChannelCount];
+
+    // Written by the PulseAudio thread, read on the main thread
+    static std::atomic<uint32_t> levels[ChannelCount];
+    static std::atomic<bool> deliveryQueued = false;
+
+    struct Listener
+    {
+        uint32_t id;
+        std::function<void(const System::AudioLevel&)> callback;
+    };
+    static std::vector<Listener> listeners;
+    static uint32_t nextListenerId = 0;
+
+    static void Connect();
+
+    static void Deliver()
+    {
+        deliveryQueued = false;
+        System::AudioLevel level;
+        level.sink = (double)levels[Sink] / levelSteps;
+        level.source = (double)levels[Source] / levelSteps;
+        for (size_t i = 0; i < listeners.size(); i++)
+        {
+            // Copy, since the callback may remove itself
+            std::function<void(const System::AudioLevel&)> callback = listeners[i].callback;
+            callback(level);
+        }
+    }
+
+    static void Publish(Channel channel, float peak)
+    {
+        uint32_t quantised = (uint32_t)std::lround(std::clamp(peak, 0.f, 1.f) * levelSteps);
+        if (levels[channel].exchange(quantised) == quantised)
+            return;
+        // One pending delivery carries all changes until it runs
+        if (!deliveryQueued.exchange(true))
+        {
+            PostToMain(Deliver);
+        }
+    }
+
+    static void OnRead(pa_stream* stream, size_t, void* userdata)
+    {
+        Channel channel = (Channel)(uintptr_t)userdata;
+        float peak = 0.f;
+        const void* data;
+        size_t size;
+        // Drain everything, the server may have sent more than one peak
+        while (pa_stream_readable_size(stream) > 0)
+        {
+            if (pa_stream_peek(stream, &data, &size) < 0)
+                return;
+            if (size == 0)
+                break;
+            // data is null for holes
+            if (data)
+            {
+                peak = std::max(peak, MaxAbs((const float*)data, size / sizeof(float)));
+            }
+            pa_stream_drop(stream);
+        }
+        Publish(channel, peak);
+    }
+
+    static void DisconnectStream(Channel channel)
+    {
+        if (!streams[channel])
+            return;
+        pa_stream_set_read_callback(streams[channel], nullptr, nullptr);
+        pa_stream_disconnect(streams[channel]);
+        pa_stream_unref(streams[channel]);
+        streams[channel] = nullptr;
+    }
+
+    static void ConnectStream(Channel channel)
+    {
+        DisconnectStream(channel);
+
+        pa_sample_spec spec;
+        spec.format = PA_SAMPLE_FLOAT32NE;
+        spec.rate = rate;
+        spec.channels = 1;
+        pa_stream* stream = pa_stream_new(context, "gBar peak meter", &spec, nullptr);
+        if (!stream)
+        {
+            LOG("PeakMeter: Failed to create stream: " << pa_strerror(pa_context_errno(context)));
+            return;
+        }
+        pa_stream_set_read_callback(stream, OnRead, (void*)(uintptr_t)channel);
+
+        // Deliver every peak as soon as it is there
+        pa_buffer_attr attr;
+        attr.maxlength = (uint32_t)-1;
+        attr.fragsize = sizeof(float);
+        attr.tlength = attr.prebuf = attr.minreq = (uint32_t)-1;
+        pa_stream_flags_t flags = (pa_stream_flags_t)(PA_STREAM_PEAK_DETECT | PA_STREAM_ADJUST_LATENCY | PA_STREAM_DONT_INHIBIT_AUTO_SUSPEND);
+        if (pa_stream_connect_record(stream, channelDevices[channel], &attr, flags) < 0)
+        {
+            LOG("PeakMeter: Failed to connect to " << channelDevices[channel] << ": " << pa_strerror(pa_context_errno(context)));
+            pa_stream_unref(stream);
+            return;
+        }
+        streams[channel] = stream;
+    }
+
+    static void OnSubscription(pa_context*, pa_subscription_event_type_t, uint32_t, void*)
+    {
+        // Only server events are subscribed, which is where the default sink/source change
+        ConnectStream(Sink);
+        ConnectStream(Source);
+    }
+
+    static void OnReconnect(pa_mainloop_api* api, pa_time_event* event, const struct timeval*, void*)
+    {
+        api->time_free(event);
+        Connect();
+    }
+
+    static void OnStateChange(pa_context* ctx, void*)
+    {
+        switch (pa_context_get_state(ctx))
+        {
+        case PA_CONTEXT_READY:
+        {
+            pa_context_set_subscribe_callback(ctx, OnSubscription, nullptr);
+            pa_operation* op = pa_context_subscribe(ctx, PA_SUBSCRIPTION_MASK_SERVER, nullptr, nullptr);
+            if (op)
+                pa_operation_unref(op);
+            ConnectStream(Sink);
+            ConnectStream(Source);
+            break;
+        }
+        case PA_CONTEXT_FAILED:
+        case PA_CONTEXT_TERMINATED:
+            // The server went away. Show silence and try again in a second.
+            Publish(Sink, 0.f);
+            Publish(Source, 0.f);
+            pa_context_rttime_new(ctx, pa_rtclock_now() + PA_USEC_PER_SEC, OnReconnect, nullptr);
+            break;
+        default: break;
+        }
+    }
+
+    static void Disconnect()
+    {
+        for (int channel = 0; channel < ChannelCount; channel++)
+        {
+            DisconnectStream((Channel)channel);
+        }
+        if (context)
+        {
+            pa_context_set_state_callback(context, nullptr, nullptr);
+            pa_context_set_subscribe_callback(context, nullptr, nullptr);
+            pa_context_disconnect(context);
+            pa_context_unref(context);
+            context = nullptr;
+        }
+    }
+
+    static void Connect()
+    {
+        Disconnect();
+        context = pa_context_new(pa_threaded_mainloop_get_api(mainLoop), "gBar");
+        pa_context_set_state_callback(context, OnStateChange, nullptr);
+        pa_context_connect(context, nullptr, (pa_context_flags_t)(PA_CONTEXT_NOAUTOSPAWN | PA_CONTEXT_NOFAIL), nullptr);
+    }
+
+    static void Start()
+    {
+        mainLoop = pa_threaded_mainloop_new();
+        Connect();
+        if (pa_threaded_mainloop_start(mainLoop) < 0)
+        {
+            LOG("PeakMeter: Failed to start the PulseAudio thread");
+        }
+    }
+
+    static void Stop()
+    {
+        if (!mainLoop)
+            return;
+        // Joins the thread, so everything can be torn down without locking
+        pa_threaded_mainloop_stop(mainLoop);
+        Disconnect();
+        pa_threaded_mainloop_free(mainLoop);
+        mainLoop = nullptr;
+        levels[Sink] = 0;
+        levels[Source] = 0;
+    }
+
+    uint32_t AddListener(std::function<void(const System::AudioLevel&)>&& callback)
+    {
+        if (listeners.empty())
+        {
+            Start();
+        }
+        uint32_t id = nextListenerId++;
+        listeners.push_back({id, std::move(callback)});
+        return id;
+    }
+
+    void RemoveListener(uint32_t id)
+    {
+        listeners.erase(std::remove_if(listeners.begin(), listeners.end(),
+                                       [&](const Listener& listener)
+                                       {
+                                           return listener.id == id;
+                                       }),
+                        listeners.end());
+        if (listeners.empty())
+        {
+            Stop();
+        }
+    }
+
+    void Shutdown()
+    {
+        listeners.clear();
+        Stop();
+    }
+}
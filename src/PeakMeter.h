@@ -0,0 +1,46 @@
+#pragma once
+#include "System.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Peak levels of the default sink (via its monitor) and the default source. The server does the peak detection and only sends ~25 peaks per
+// second, which are reduced on a PulseAudio thread. The listeners are called on the main thread, but only when a quantised level changed.
+// Works with PipeWire as well, through pipewire-pulse.
+namespace PeakMeter
+{
+    // Metering only runs while a listener is registered. Returns an id for removal.
+    uint32_t AddListener(std::function<void(const System::AudioLevel&)>&& callback);
+    void RemoveListener(uint32_t id);
+
+    // Largest absolute sample value. Inline, so it can be benchmarked without PulseAudio (see bench/Bench.cpp).
+    inline float MaxAbs(const float* samples, size_t count)
+    {
+        float peak = 0.f;
+        size_t i = 0;
+#ifdef __SSE2__
+        // Clearing the sign bit is abs, four samples at a time
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 peaks = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4)
+        {
+            peaks = _mm_max_ps(peaks, _mm_and_ps(_mm_loadu_ps(samples + i), absMask));
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, peaks);
+        peak = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+        for (; i < count; i++)
+        {
+            peak = std::max(peak, std::fabs(samples[i]));
+        }
+        return peak;
+    }
+
+    void Shutdown();
+}
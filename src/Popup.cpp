@@ -0,0 +1,89 @@
+#include "Popup.h"
+#include "Window.h"
+#include "AudioFlyin.h"
+#include "BluetoothDevices.h"
+#include "Mixer.h"
+#include "Config.h"
+#include "Common.h"
+
+#include <memory>
+
+namespace Popup
+{
+    enum Slot
+    {
+        FlyinSlot,
+        BluetoothSlot,
+        MixerSlot,
+        SlotCount
+    };
+    static std::unique_ptr<Window> windows[SlotCount];
+
+    static Slot GetSlot(Type type)
+    {
+        switch (type)
+        {
+        case Type::Audio:
+        case Type::Mic: return FlyinSlot;
+        case Type::Bluetooth: return BluetoothSlot;
+        case Type::Mixer: return MixerSlot;
+        }
+        return FlyinSlot;
+    }
+
+    static void CreateWidget(Type type, Window& window)
+    {
+        switch (type)
+        {
+        case Type::Audio: AudioFlyin::Create(window, window.GetName(), AudioFlyin::Type::Speaker); break;
+        case Type::Mic: AudioFlyin::Create(window, window.GetName(), AudioFlyin::Type::Microphone); break;
+#ifdef WITH_BLUEZ
+        case Type::Bluetooth: BluetoothDevices::Create(window, window.GetName()); break;
+#else
+        case Type::Bluetooth: break;
+#endif
+        case Type::Mixer: Mixer::Create(window, window.GetName()); break;
+        }
+    }
+
+    void Open(Type type, const std::string& monitor)
+    {
+        Slot slot = GetSlot(type);
+        if (windows[slot])
+            return;
+        if (type == Type::Bluetooth && !RuntimeConfig::Get().hasBlueZ)
+        {
+            LOG("Popup: Bluetooth disabled, cannot open bluetooth widget!");
+            return;
+        }
+
+        windows[slot] = std::make_unique<Window>(monitor);
+        Window& window = *windows[slot];
+        window.OnWidget = [type, &window]()
+        {
+            CreateWidget(type, window);
+        };
+        window.OnClose = [slot]()
+        {
+            windows[slot] = nullptr;
+        };
+        window.Open();
+    }
+
+    bool IsOpen(Type type)
+    {
+        return windows[GetSlot(type)] != nullptr;
+    }
+
+    void CloseAll()
+    {
+        for (auto& window : windows)
+        {
+            if (!window)
+                continue;
+            // Deleting the Window alone keeps the layer surface mapped. This also drops a queued close, which would use the deleted window.
+            window->Destroy();
+            window = nullptr;
+        }
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+
+// Flyins, the bluetooth widget and the mixer as extra windows of the running bar. Everything is already initialized, so they show up
+// on the next frame instead of starting a new gBar process.
+namespace Popup
+{
+    enum class Type
+    {
+        Audio,
+        Mic,
+        Bluetooth,
+        Mixer
+    };
+
+    // Does nothing, if the popup is already open. The audio and mic flyin share one window, just like the process based ones.
+    void Open(Type type, const std::string& monitor);
+    bool IsOpen(Type type);
+
+    // Destroys all popups. Call before System::FreeResources.
+    void CloseAll();
+}
@@ -0,0 +1,125 @@
+#include "ProcParse.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace ProcParse
+{
+    // Parses a decimal number at it, skipping leading spaces. Returns the position after the number.
+    static const char* ParseUInt(const char* it, const char* end, uint64_t& out)
+    {
+        while (it != end && *it == ' ')
+        {
+            it++;
+        }
+        out = 0;
+        while (it != end && *it >= '0' && *it <= '9')
+        {
+            out = out * 10 + (*it - '0');
+            it++;
+        }
+        return it;
+    }
+
+    // Parses the columns of a "cpu" line. it must point after the label.
+    static const char* ParseCPULine(const char* it, const char* end, CPUTimestamp& out)
+    {
+        for (uint64_t& field : out.fields)
+        {
+            it = ParseUInt(it, end, field);
+        }
+        return it;
+    }
+
+    bool ParseCPU(std::string_view content, CPUTimestamp& out)
+    {
+        if (content.substr(0, 4) != "cpu ")
+        {
+            return false;
+        }
+        ParseCPULine(content.data() + 4, content.data() + content.size(), out);
+        return true;
+    }
+
+    void ParseCPUCores(std::string_view content, uint32_t numCores, uint64_t* total, uint64_t* idle)
+    {
+        std::fill(total, total + numCores, 0);
+        std::fill(idle, idle + numCores, 0);
+
+        const char* it = content.data();
+        const char* end = content.data() + content.size();
+        while (it != end)
+        {
+            // The cpuN lines directly follow the aggregate one and are the only other lines starting with cpu
+            const char* endLine = (const char*)memchr(it, '\n', end - it);
+            endLine = endLine ? endLine : end;
+            std::string_view line(it, endLine - it);
+            it = endLine == end ? end : endLine + 1;
+            if (line.substr(0, 3) != "cpu")
+            {
+                break;
+            }
+            if (line.size() <= 3 || line[3] == ' ')
+            {
+                // Aggregate
+                continue;
+            }
+
+            uint64_t core;
+            const char* columns = ParseUInt(line.data() + 3, endLine, core);
+            if (core >= numCores)
+            {
+                continue;
+            }
+            CPUTimestamp timestamp;
+            ParseCPULine(columns, endLine, timestamp);
+            total[core] = timestamp.Total();
+            idle[core] = timestamp.Get(CPUField::Idle);
+        }
+    }
+
+    System::RAMInfo ParseMemInfo(std::string_view content)
+    {
+        using System::RAMInfo;
+        struct MemInfoKey
+        {
+            std::string_view key;
+            double RAMInfo::*field;
+        };
+        static constexpr MemInfoKey keys[] = {
+            {"MemTotal", &RAMInfo::totalGiB},  {"MemAvailable", &RAMInfo::freeGiB},    {"Buffers", &RAMInfo::buffersGiB},
+            {"Cached", &RAMInfo::cachedGiB},   {"SwapTotal", &RAMInfo::swapTotalGiB}, {"SwapFree", &RAMInfo::swapFreeGiB},
+        };
+        constexpr uint32_t allKeys = (1u << std::size(keys)) - 1;
+
+        RAMInfo out{};
+        uint32_t foundKeys = 0;
+        const char* it = content.data();
+        const char* end = content.data() + content.size();
+        // Lines are "<Key>:<spaces><value> kB". Stop as soon as we've seen everything we need.
+        while (it != end && foundKeys != allKeys)
+        {
+            const char* colon = (const char*)memchr(it, ':', end - it);
+            if (!colon)
+            {
+                break;
+            }
+            std::string_view key(it, colon - it);
+            for (size_t i = 0; i < std::size(keys); i++)
+            {
+                if (keys[i].key == key)
+                {
+                    uint64_t kiB;
+                    ParseUInt(colon + 1, end, kiB);
+                    out.*keys[i].field = (double)kiB / (1024 * 1024);
+                    foundKeys |= 1u << i;
+                    break;
+                }
+            }
+            const char* endLine = (const char*)memchr(colon, '\n', end - colon);
+            it = endLine ? endLine + 1 : end;
+        }
+        return out;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "System.h"
+
+#include <cstdint>
+#include <string_view>
+
+// Allocation-free parsers for the contents of /proc/stat and /proc/meminfo. They don't touch any file or global state, so they can be
+// benchmarked on their own (see bench/Bench.cpp).
+namespace ProcParse
+{
+    // Fields of a cpu line in /proc/stat, in the order they appear.
+    // guest and guest_nice are already accounted for in user and nice, so we don't read them.
+    enum class CPUField
+    {
+        User,
+        Nice,
+        System,
+        Idle,
+        IOWait,
+        IRQ,
+        SoftIRQ,
+        Steal,
+        Count
+    };
+
+    struct CPUTimestamp
+    {
+        uint64_t fields[(size_t)CPUField::Count]{};
+
+        uint64_t Get(CPUField field) const { return fields[(size_t)field]; }
+        uint64_t Total() const
+        {
+            uint64_t total = 0;
+            for (uint64_t field : fields)
+            {
+                total += field;
+            }
+            return total;
+        }
+    };
+
+    // Parses the aggregate "cpu " line, which is always the first one. Returns false, if content doesn't start with it.
+    bool ParseCPU(std::string_view content, CPUTimestamp& out);
+    // Fills the total and idle time of each core from the cpuN lines. total and idle must have numCores entries.
+    // Offline cores have no line and are set to 0.
+    void ParseCPUCores(std::string_view content, uint32_t numCores, uint64_t* total, uint64_t* idle);
+
+    System::RAMInfo ParseMemInfo(std::string_view content);
+}
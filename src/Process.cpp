@@ -0,0 +1,291 @@
+#include "Process.h"
+#include "Common.h"
+
+#include <glib.h>
+#include <glib-unix.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace Process
+{
+    // Captured output is for short answers (e.g. a number). Anything beyond this is dropped.
+    constexpr size_t maxOutputSize = 1024 * 1024;
+
+    struct Job
+    {
+        uint32_t id;
+        GPid pid;
+        int outFd = -1;
+        guint outSource = 0;
+        guint childSource = 0;
+        ExitCallback onExit;
+        Options options;
+        std::string output;
+    };
+    // Jobs are removed, when the process exits or is cancelled. Their sources are removed with them.
+    static std::unordered_map<uint32_t, std::unique_ptr<Job>> jobs;
+    static uint32_t nextId = 1;
+
+    static void CloseOutput(Job& job)
+    {
+        if (job.outSource)
+        {
+            g_source_remove(job.outSource);
+            job.outSource = 0;
+        }
+        if (job.outFd >= 0)
+        {
+            close(job.outFd);
+            job.outFd = -1;
+        }
+    }
+
+    // Reads everything, that is available right now. Returns true on EOF.
+    static bool ReadOutput(Job& job, std::string& chunk)
+    {
+        char buf[4096];
+        while (true)
+        {
+            ssize_t bytesRead = read(job.outFd, buf, sizeof(buf));
+            if (bytesRead > 0)
+            {
+                chunk.append(buf, bytesRead);
+                continue;
+            }
+            if (bytesRead < 0 && errno == EINTR)
+                continue;
+            return bytesRead == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+        }
+    }
+
+    // Returns false, if the job was cancelled from the callback
+    static bool DeliverOutput(Job& job, std::string&& chunk)
+    {
+        if (chunk.empty())
+            return true;
+        if (!job.options.onOutput)
+        {
+            if (job.output.size() < maxOutputSize)
+                job.output.append(chunk, 0, maxOutputSize - job.output.size());
+            return true;
+        }
+        uint32_t id = job.id;
+        auto onOutput = job.options.onOutput;
+        onOutput(chunk);
+        return jobs.find(id) != jobs.end();
+    }
+
+    static gboolean OnOutput(gint, GIOCondition, gpointer data)
+    {
+        Job& job = *(Job*)data;
+        std::string chunk;
+        bool eof = ReadOutput(job, chunk);
+        if (eof)
+        {
+            // Returning G_SOURCE_REMOVE removes the source
+            job.outSource = 0;
+            CloseOutput(job);
+        }
+        if (!DeliverOutput(job, std::move(chunk)))
+            return G_SOURCE_REMOVE;
+        return eof ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
+    }
+
+    static void Reap(GPid pid)
+    {
+        g_child_watch_add(
+            pid,
+            [](GPid pid, gint, gpointer)
+            {
+                g_spawn_close_pid(pid);
+            },
+            nullptr);
+    }
+
+    static void OnExit(GPid pid, gint status, gpointer data)
+    {
+        Job& job = *(Job*)data;
+        g_spawn_close_pid(pid);
+        job.childSource = 0;
+
+        // Whatever the process wrote before exiting is already in the pipe. Don't wait for EOF, something it started may hold the pipe open.
+        if (job.outFd >= 0)
+        {
+            std::string chunk;
+            ReadOutput(job, chunk);
+            CloseOutput(job);
+            if (!DeliverOutput(job, std::move(chunk)))
+                return;
+        }
+
+        Result result;
+        result.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        result.output = std::move(job.output);
+        ExitCallback onExit = std::move(job.onExit);
+        // Erase first, the callback may start the next process
+        jobs.erase(job.id);
+        if (onExit)
+            onExit(result);
+    }
+
+    static void SetPriority(pid_t pid, const Options& options)
+    {
+        // posix_spawn can't run code in the child, so this is applied right after the start. It is applied to the whole process group
+        // (pgid == pid, see Spawn()), so children the process already started don't escape it. ESRCH: Everything already exited.
+        if (options.nice > 0)
+        {
+            int niceness = std::min(getpriority(PRIO_PROCESS, 0) + options.nice, 19);
+            if (setpriority(PRIO_PGRP, pid, niceness) < 0 && errno != ESRCH)
+            {
+                LOG("Process: Cannot set niceness: " << strerror(errno));
+            }
+        }
+        if (options.ioniceClass != 0)
+        {
+            // See ioprio_set(2). There is no glibc wrapper.
+            constexpr int ioprioWhoProcessGroup = 2;
+            constexpr int ioprioClassShift = 13;
+            int ioprio = (options.ioniceClass << ioprioClassShift) | std::clamp(options.ioniceLevel, 0, 7);
+            if (syscall(SYS_ioprio_set, ioprioWhoProcessGroup, pid, ioprio) < 0 && errno != ESRCH)
+            {
+                LOG("Process: Cannot set I/O priority: " << strerror(errno));
+            }
+        }
+    }
+
+    static pid_t Spawn(const std::vector<std::string>& argv, bool pipeOutput, int& outFd)
+    {
+        std::vector<char*> cArgv;
+        for (auto& arg : argv)
+        {
+            cArgv.push_back((char*)arg.c_str());
+        }
+        cArgv.push_back(nullptr);
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+        int pipeFds[2] = {-1, -1};
+        if (pipeOutput)
+        {
+            if (pipe2(pipeFds, O_CLOEXEC) < 0)
+            {
+                LOG("Process: Cannot create pipe: " << strerror(errno));
+                posix_spawn_file_actions_destroy(&actions);
+                return -1;
+            }
+            posix_spawn_file_actions_adddup2(&actions, pipeFds[1], STDOUT_FILENO);
+        }
+
+        // Own process group, so Cancel() also reaches whatever the process started
+        posix_spawnattr_t attr;
+        posix_spawnattr_init(&attr);
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+        posix_spawnattr_setpgroup(&attr, 0);
+        sigset_t signals;
+        sigemptyset(&signals);
+        posix_spawnattr_setsigmask(&attr, &signals);
+        sigaddset(&signals, SIGPIPE);
+        posix_spawnattr_setsigdefault(&attr, &signals);
+
+        pid_t pid;
+        int err = posix_spawnp(&pid, cArgv[0], &actions, &attr, cArgv.data(), environ);
+        posix_spawnattr_destroy(&attr);
+        posix_spawn_file_actions_destroy(&actions);
+
+        if (pipeFds[1] >= 0)
+            close(pipeFds[1]);
+        if (err != 0)
+        {
+            LOG("Process: Cannot run " << argv[0] << ": " << strerror(err));
+            if (pipeFds[0] >= 0)
+                close(pipeFds[0]);
+            return -1;
+        }
+        outFd = pipeFds[0];
+        return pid;
+    }
+
+    uint32_t Run(const std::vector<std::string>& argv, ExitCallback&& onExit, Options&& options)
+    {
+        ASSERT(!argv.empty(), "Process: Empty command line");
+        int outFd = -1;
+        pid_t pid = Spawn(argv, options.captureOutput || options.onOutput, outFd);
+        if (pid < 0)
+        {
+            // Report it from the main loop as well, the caller may not expect the callback to run right away
+            if (onExit)
+            {
+                g_idle_add(
+                    [](gpointer data)
+                    {
+                        ExitCallback* onExit = (ExitCallback*)data;
+                        (*onExit)(Result{});
+                        delete onExit;
+                        return G_SOURCE_REMOVE;
+                    },
+                    new ExitCallback(std::move(onExit)));
+            }
+            return 0;
+        }
+        SetPriority(pid, options);
+
+        uint32_t id = nextId++;
+        auto job = std::make_unique<Job>();
+        job->id = id;
+        job->pid = pid;
+        job->onExit = std::move(onExit);
+        job->options = std::move(options);
+        job->outFd = outFd;
+        if (outFd >= 0)
+        {
+            g_unix_set_fd_nonblocking(outFd, true, nullptr);
+            job->outSource = g_unix_fd_add(outFd, (GIOCondition)(G_IO_IN | G_IO_HUP | G_IO_ERR), OnOutput, job.get());
+        }
+        job->childSource = g_child_watch_add(pid, OnExit, job.get());
+        jobs.emplace(id, std::move(job));
+        return id;
+    }
+
+    uint32_t RunShell(const std::string& command, ExitCallback&& onExit, Options&& options)
+    {
+        return Run({"/bin/sh", "-c", command}, std::move(onExit), std::move(options));
+    }
+
+    void Cancel(uint32_t id, int signal)
+    {
+        auto it = jobs.find(id);
+        if (it == jobs.end())
+            return;
+        Job& job = *it->second;
+        CloseOutput(job);
+        // Already reaped, if cancelled from the output callback during exit
+        if (job.childSource)
+        {
+            g_source_remove(job.childSource);
+            kill(-job.pid, signal);
+            Reap(job.pid);
+        }
+        jobs.erase(it);
+    }
+
+    void Shutdown()
+    {
+        for (auto& [id, job] : jobs)
+        {
+            CloseOutput(*job);
+            if (job->childSource)
+                g_source_remove(job->childSource);
+        }
+        jobs.clear();
+    }
+}
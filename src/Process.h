@@ -0,0 +1,48 @@
+#pragma once
+#include <csignal>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Runs external programs without blocking the main thread. Processes are started with posix_spawn in their own process group and
+// reaped through a GLib child watch, so all callbacks are called on the main loop. Must be used from the main thread.
+namespace Process
+{
+    struct Result
+    {
+        // -1, if the process couldn't be started or was killed by a signal
+        int exitCode = -1;
+        // Only filled, if Options::captureOutput is set
+        std::string output;
+    };
+
+    struct Options
+    {
+        // Collect stdout into Result::output
+        bool captureOutput = false;
+        // Called with stdout as it arrives instead of collecting it. Each call contains everything, that was read at once.
+        std::function<void(std::string_view chunk)> onOutput;
+
+        // Added to the niceness of the process (0-19)
+        int nice = 0;
+        // I/O scheduling class like ionice(1): 0 = Don't change, 1 = Realtime, 2 = Best-effort, 3 = Idle
+        int ioniceClass = 0;
+        // Priority within the class (0-7). Lower is higher priority
+        int ioniceLevel = 4;
+    };
+
+    using ExitCallback = std::function<void(const Result& result)>;
+
+    // Runs argv[0] (looked up in PATH). Returns an id for Cancel(), or 0 if starting failed. onExit is called in both cases.
+    uint32_t Run(const std::vector<std::string>& argv, ExitCallback&& onExit = {}, Options&& options = {});
+    // Runs the command through /bin/sh -c
+    uint32_t RunShell(const std::string& command, ExitCallback&& onExit = {}, Options&& options = {});
+
+    // Sends the signal to the process group and drops the callbacks. The process is still reaped in the background.
+    void Cancel(uint32_t id, int signal = SIGTERM);
+
+    // Drops all callbacks, without killing anything (e.g. a lock screen should outlive the bar)
+    void Shutdown();
+}
@@ -5,45 +5,87 @@
 
 #include <cmath>
 #include <pulse/pulseaudio.h>
+#include <pulse/glib-mainloop.h>
 #include <stdlib.h>
 #include <algorithm>
-#include <list>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
+// PulseAudio runs on the GLib main loop, so all callbacks (and the listeners) are called on the main thread.
 namespace PulseAudio
 {
 
-    static pa_mainloop* mainLoop;
+    static pa_glib_mainloop* mainLoop;
     static pa_context* context;
-    static std::list<pa_operation*> pendingOperations;
+    static guint reconnectSource = 0;
 
     static System::AudioInfo info;
+    // Info requests of the running update, that haven't finished yet
+    static uint32_t pendingInfo = 0;
+    // Something changed while an update was running
     static bool queueUpdate = false;
-    static bool blockUpdate = false;
 
-    inline void FlushLoop()
+    // Names and volumes of the default sink/source, for setting volume and mute
+    static std::string defaultSink;
+    static std::string defaultSource;
+    static pa_cvolume sinkVolume;
+    static pa_cvolume sourceVolume;
+
+    // Only one volume change per device/stream is sent at a time. Values set while it is in flight replace each other and only the newest
+    // one is sent, once the server acknowledged the previous one.
+    struct VolumeRequest
+    {
+        System::AudioStreamType type;
+        // PA_INVALID_INDEX targets the default sink/source
+        uint32_t index = PA_INVALID_INDEX;
+        pa_operation* inFlight = nullptr;
+        std::optional<pa_cvolume> queued;
+    };
+    static VolumeRequest sinkRequest{System::AudioStreamType::Sink, PA_INVALID_INDEX, nullptr, {}};
+    static VolumeRequest sourceRequest{System::AudioStreamType::Source, PA_INVALID_INDEX, nullptr, {}};
+
+    struct Listener
+    {
+        uint32_t id;
+        std::function<void(const System::AudioInfo&)> callback;
+    };
+    static std::vector<Listener> listeners;
+    static uint32_t nextListenerId = 0;
+
+    // Sinks, sources and sink inputs for the mixer. Only tracked while someone listens for them, since e.g. every browser tab is a sink
+    // input. Updated per index from the subscription events.
+    struct Stream
+    {
+        System::AudioStream stream;
+        pa_cvolume volume;
+        VolumeRequest request;
+    };
+    static std::unordered_map<uint64_t, Stream> streams;
+
+    struct StreamListener
+    {
+        uint32_t id;
+        std::function<void(const System::AudioStream&, bool)> callback;
+    };
+    static std::vector<StreamListener> streamListeners;
+
+    inline bool IsReady()
     {
-        while (pendingOperations.size() > 0)
+        return context && pa_context_get_state(context) == PA_CONTEXT_READY;
+    }
+
+    // We only need the callbacks of operations, not the operations themselves. Returns false, if the operation couldn't be started.
+    inline bool Issue(pa_operation* op)
+    {
+        if (!op)
         {
-            pa_mainloop_iterate(mainLoop, 0, nullptr);
-            // Remove done or cancelled operations
-            pendingOperations.remove_if(
-                [](pa_operation* op)
-                {
-                    pa_operation_state_t state = pa_operation_get_state(op);
-                    if (state == PA_OPERATION_DONE)
-                    {
-                        pa_operation_unref(op);
-                        return true;
-                    }
-                    else if (state == PA_OPERATION_CANCELLED)
-                    {
-                        LOG("Warning: Cancelled pa_operation!");
-                        pa_operation_unref(op);
-                        return true;
-                    }
-                    return false;
-                });
+            LOG("PulseAudio: Operation failed: " << pa_strerror(pa_context_errno(context)));
+            return false;
         }
+        pa_operation_unref(op);
+        return true;
     }
 
     inline double PAVolumeToDouble(const pa_cvolume* volume)
@@ -78,192 +120,605 @@ namespace PulseAudio
         return volRemapped;
     }
 
-    inline void UpdateInfo()
+    inline void NotifyListeners()
     {
-        LOG("PulseAudio: Update info");
-        struct ServerInfo
+        // Callbacks may remove themselves, so don't hold on to iterators
+        for (size_t i = 0; i < listeners.size(); i++)
         {
-            const char* defaultSink = nullptr;
-            const char* defaultSource = nullptr;
-        } serverInfo;
+            // Copy, since the callback may remove itself
+            std::function<void(const System::AudioInfo&)> callback = listeners[i].callback;
+            callback(info);
+        }
+    }
 
-        // 1. Get default sink
-        auto getServerInfo = [](pa_context*, const pa_server_info* paInfo, void* out)
+    inline uint64_t StreamKey(System::AudioStreamType type, uint32_t index)
+    {
+        return ((uint64_t)type << 32) | index;
+    }
+
+    inline void NotifyStreamListeners(const System::AudioStream& stream, bool removed)
+    {
+        for (size_t i = 0; i < streamListeners.size(); i++)
         {
-            if (!paInfo)
-                return;
+            std::function<void(const System::AudioStream&, bool)> callback = streamListeners[i].callback;
+            callback(stream, removed);
+        }
+    }
 
-            ServerInfo* serverInfo = (ServerInfo*)out;
-            serverInfo->defaultSink = paInfo->default_sink_name;
-            serverInfo->defaultSource = paInfo->default_source_name;
+    inline bool IsDefault(const System::AudioStream& stream)
+    {
+        switch (stream.type)
+        {
+        case System::AudioStreamType::Sink: return stream.name == defaultSink;
+        case System::AudioStreamType::Source: return stream.name == defaultSource;
+        default: return false;
+        }
+    }
 
-            auto sinkInfo = [](pa_context*, const pa_sink_info* paInfo, int, void* audioInfo)
+    // The default sink/source was switched
+    inline void UpdateDefaultStreams()
+    {
+        for (auto& [key, stream] : streams)
+        {
+            bool isDefault = IsDefault(stream.stream);
+            if (isDefault != stream.stream.isDefault)
             {
-                if (!paInfo)
-                    return;
+                stream.stream.isDefault = isDefault;
+                NotifyStreamListeners(stream.stream, false);
+            }
+        }
+    }
 
-                System::AudioInfo* out = (System::AudioInfo*)audioInfo;
+    inline void UpdateInfo();
 
-                double vol = PAVolumeToDoubleWithMinMax(&paInfo->volume);
-                out->sinkVolume = vol;
-                out->sinkMuted = paInfo->mute;
-            };
-            if (serverInfo->defaultSink)
+    // Called, when one of the requests of the running update finished. The last one publishes the info.
+    inline void FinishInfo()
+    {
+        if (--pendingInfo > 0)
+            return;
+
+        NotifyListeners();
+        if (queueUpdate)
+        {
+            queueUpdate = false;
+            UpdateInfo();
+        }
+    }
+
+    inline void UpdateInfo()
+    {
+        if (pendingInfo > 0)
+        {
+            // Bursts of events only cause one more update
+            queueUpdate = true;
+            return;
+        }
+        LOG("PulseAudio: Update info");
+
+        // 1. Get default sink and source
+        auto getServerInfo = [](pa_context*, const pa_server_info* paInfo, void*)
+        {
+            if (paInfo)
             {
-                pa_operation* op = pa_context_get_sink_info_by_name(context, serverInfo->defaultSink, +sinkInfo, &info);
-                pa_operation_ref(op);
-                pendingOperations.push_back(op);
+                defaultSink = paInfo->default_sink_name ? paInfo->default_sink_name : "";
+                defaultSource = paInfo->default_source_name ? paInfo->default_source_name : "";
+                UpdateDefaultStreams();
+
+                // 2. Get their volumes. The callbacks are called once more without info at the end of the list.
+                auto sinkInfo = [](pa_context*, const pa_sink_info* paInfo, int, void*)
+                {
+                    if (!paInfo)
+                    {
+                        FinishInfo();
+                        return;
+                    }
+                    sinkVolume = paInfo->volume;
+                    // Don't jump back to an old volume, while our own changes are still on their way
+                    if (!sinkRequest.inFlight)
+                        info.sinkVolume = PAVolumeToDoubleWithMinMax(&paInfo->volume);
+                    info.sinkMuted = paInfo->mute;
+                };
+                if (!defaultSink.empty())
+                {
+                    pendingInfo++;
+                    if (!Issue(pa_context_get_sink_info_by_name(context, defaultSink.c_str(), +sinkInfo, nullptr)))
+                        FinishInfo();
+                }
+
+                auto sourceInfo = [](pa_context*, const pa_source_info* paInfo, int, void*)
+                {
+                    if (!paInfo)
+                    {
+                        FinishInfo();
+                        return;
+                    }
+                    sourceVolume = paInfo->volume;
+                    if (!sourceRequest.inFlight)
+                        info.sourceVolume = PAVolumeToDouble(&paInfo->volume);
+                    info.sourceMuted = paInfo->mute;
+                };
+                if (!defaultSource.empty())
+                {
+                    pendingInfo++;
+                    if (!Issue(pa_context_get_source_info_by_name(context, defaultSource.c_str(), +sourceInfo, nullptr)))
+                        FinishInfo();
+                }
             }
+            // The server info itself
+            FinishInfo();
+        };
+
+        pendingInfo++;
+        if (!Issue(pa_context_get_server_info(context, +getServerInfo, nullptr)))
+            FinishInfo();
+    }
 
-            auto sourceInfo = [](pa_context*, const pa_source_info* paInfo, int, void* audioInfo)
+    inline System::AudioInfo GetInfo()
+    {
+        return info;
+    }
+
+    inline uint32_t AddListener(std::function<void(const System::AudioInfo&)>&& callback)
+    {
+        uint32_t id = nextListenerId++;
+        listeners.push_back({id, std::move(callback)});
+        return id;
+    }
+
+    inline void RemoveListener(uint32_t id)
+    {
+        listeners.erase(std::remove_if(listeners.begin(), listeners.end(),
+                                       [&](const Listener& listener)
+                                       {
+                                           return listener.id == id;
+                                       }),
+                        listeners.end());
+    }
+
+    inline void CancelRequest(VolumeRequest& request)
+    {
+        if (request.inFlight)
+        {
+            // Cancelled operations don't call their callback
+            pa_operation_cancel(request.inFlight);
+            pa_operation_unref(request.inFlight);
+            request.inFlight = nullptr;
+        }
+        request.queued = {};
+    }
+
+    inline void OnStreamInfo(System::AudioStreamType type, uint32_t index, const char* name, std::string&& description, const pa_cvolume& volume,
+                             bool muted)
+    {
+        // Tracking was stopped, while the request was in flight
+        if (streamListeners.empty())
+            return;
+        Stream& stream = streams[StreamKey(type, index)];
+        stream.stream.type = type;
+        stream.stream.index = index;
+        stream.stream.name = name ? name : "";
+        stream.stream.description = std::move(description);
+        stream.volume = volume;
+        stream.request.type = type;
+        stream.request.index = index;
+        // Don't jump back to an old volume, while our own changes are still on their way
+        if (!stream.request.inFlight)
+            stream.stream.volume = PAVolumeToDouble(&volume);
+        stream.stream.muted = muted;
+        stream.stream.isDefault = IsDefault(stream.stream);
+        NotifyStreamListeners(stream.stream, false);
+    }
+
+    // Requests the info of one stream, or all streams of the type for PA_INVALID_INDEX
+    inline void RequestStream(System::AudioStreamType type, uint32_t index)
+    {
+        switch (type)
+        {
+        case System::AudioStreamType::Sink:
+        {
+            auto sinkInfo = [](pa_context*, const pa_sink_info* paInfo, int, void*)
+            {
+                if (paInfo)
+                    OnStreamInfo(System::AudioStreamType::Sink, paInfo->index, paInfo->name, paInfo->description, paInfo->volume, paInfo->mute);
+            };
+            Issue(index == PA_INVALID_INDEX ? pa_context_get_sink_info_list(context, +sinkInfo, nullptr)
+                                            : pa_context_get_sink_info_by_index(context, index, +sinkInfo, nullptr));
+            break;
+        }
+        case System::AudioStreamType::Source:
+        {
+            auto sourceInfo = [](pa_context*, const pa_source_info* paInfo, int, void*)
+            {
+                // Monitors of sinks aren't interesting for a mixer
+                if (paInfo && paInfo->monitor_of_sink == PA_INVALID_INDEX)
+                    OnStreamInfo(System::AudioStreamType::Source, paInfo->index, paInfo->name, paInfo->description, paInfo->volume, paInfo->mute);
+            };
+            Issue(index == PA_INVALID_INDEX ? pa_context_get_source_info_list(context, +sourceInfo, nullptr)
+                                            : pa_context_get_source_info_by_index(context, index, +sourceInfo, nullptr));
+            break;
+        }
+        case System::AudioStreamType::SinkInput:
+        {
+            auto sinkInputInfo = [](pa_context*, const pa_sink_input_info* paInfo, int, void*)
             {
-                if (!paInfo)
+                if (!paInfo || !paInfo->has_volume)
                     return;
+                // e.g. "Firefox: Some video"
+                const char* application = pa_proplist_gets(paInfo->proplist, PA_PROP_APPLICATION_NAME);
+                std::string description = application ? std::string(application) + ": " + paInfo->name : paInfo->name;
+                OnStreamInfo(System::AudioStreamType::SinkInput, paInfo->index, paInfo->name, std::move(description), paInfo->volume, paInfo->mute);
+            };
+            Issue(index == PA_INVALID_INDEX ? pa_context_get_sink_input_info_list(context, +sinkInputInfo, nullptr)
+                                            : pa_context_get_sink_input_info(context, index, +sinkInputInfo, nullptr));
+            break;
+        }
+        }
+    }
 
-                System::AudioInfo* out = (System::AudioInfo*)audioInfo;
+    inline void RemoveStream(System::AudioStreamType type, uint32_t index)
+    {
+        auto it = streams.find(StreamKey(type, index));
+        if (it == streams.end())
+            return;
+        CancelRequest(it->second.request);
+        System::AudioStream stream = std::move(it->second.stream);
+        streams.erase(it);
+        NotifyStreamListeners(stream, true);
+    }
 
-                double vol = PAVolumeToDouble(&paInfo->volume);
-                out->sourceVolume = vol;
-                out->sourceMuted = paInfo->mute;
-            };
-            if (serverInfo->defaultSource)
+    inline void OnStreamEvent(pa_subscription_event_type_t event, uint32_t index)
+    {
+        System::AudioStreamType type;
+        switch (event & PA_SUBSCRIPTION_EVENT_FACILITY_MASK)
+        {
+        case PA_SUBSCRIPTION_EVENT_SINK: type = System::AudioStreamType::Sink; break;
+        case PA_SUBSCRIPTION_EVENT_SOURCE: type = System::AudioStreamType::Source; break;
+        case PA_SUBSCRIPTION_EVENT_SINK_INPUT: type = System::AudioStreamType::SinkInput; break;
+        default: return;
+        }
+        if ((event & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE)
+            RemoveStream(type, index);
+        else
+            RequestStream(type, index);
+    }
+
+    inline void Subscribe()
+    {
+        auto subscribeSuccess = [](pa_context*, int success, void*)
+        {
+            if (!success)
             {
-                pa_operation* op = pa_context_get_source_info_by_name(context, serverInfo->defaultSource, +sourceInfo, &info);
-                pa_operation_ref(op);
-                pendingOperations.push_back(op);
+                LOG("PulseAudio: Failed to subscribe: " << pa_strerror(pa_context_errno(context)));
             }
         };
+        // Server changes are switches of the default sink/source.
+        uint32_t mask = PA_SUBSCRIPTION_MASK_SINK | PA_SUBSCRIPTION_MASK_SOURCE | PA_SUBSCRIPTION_MASK_SERVER;
+        if (!streamListeners.empty())
+            mask |= PA_SUBSCRIPTION_MASK_SINK_INPUT;
+        Issue(pa_context_subscribe(context, (pa_subscription_mask_t)mask, +subscribeSuccess, nullptr));
+    }
 
-        pa_operation* op = pa_context_get_server_info(context, +getServerInfo, &serverInfo);
-        pa_operation_ref(op);
-        pendingOperations.push_back(op);
-        FlushLoop();
+    inline void RequestAllStreams()
+    {
+        RequestStream(System::AudioStreamType::Sink, PA_INVALID_INDEX);
+        RequestStream(System::AudioStreamType::Source, PA_INVALID_INDEX);
+        RequestStream(System::AudioStreamType::SinkInput, PA_INVALID_INDEX);
     }
 
-    inline System::AudioInfo GetInfo()
+    inline void DropStreams(bool notify)
     {
-        pa_mainloop_iterate(mainLoop, 0, nullptr);
-        if (queueUpdate && !blockUpdate)
+        std::unordered_map<uint64_t, Stream> dropped;
+        std::swap(dropped, streams);
+        for (auto& [key, stream] : dropped)
         {
-            UpdateInfo();
+            CancelRequest(stream.request);
+            if (notify)
+                NotifyStreamListeners(stream.stream, true);
         }
-        queueUpdate = false;
-        blockUpdate = false;
-        return info;
     }
 
-    inline void Init()
+    inline uint32_t AddStreamListener(std::function<void(const System::AudioStream&, bool)>&& callback)
     {
-        mainLoop = pa_mainloop_new();
-        pa_mainloop_api* api = pa_mainloop_get_api(mainLoop);
+        bool startTracking = streamListeners.empty();
+        uint32_t id = nextListenerId++;
+        streamListeners.push_back({id, std::move(callback)});
+        if (startTracking)
+        {
+            if (IsReady())
+            {
+                Subscribe();
+                RequestAllStreams();
+            }
+        }
+        else
+        {
+            // Catch up with the streams, we already know of
+            for (auto& [key, stream] : streams)
+            {
+                streamListeners.back().callback(stream.stream, false);
+            }
+        }
+        return id;
+    }
+
+    inline void RemoveStreamListener(uint32_t id)
+    {
+        streamListeners.erase(std::remove_if(streamListeners.begin(), streamListeners.end(),
+                                             [&](const StreamListener& listener)
+                                             {
+                                                 return listener.id == id;
+                                             }),
+                              streamListeners.end());
+        if (streamListeners.empty())
+        {
+            DropStreams(false);
+            if (IsReady())
+                Subscribe();
+        }
+    }
 
-        context = pa_context_new(api, "gBar PA context");
-        int res = pa_context_connect(context, nullptr, PA_CONTEXT_NOAUTOSPAWN, nullptr);
+    inline void DropRequests()
+    {
+        CancelRequest(sinkRequest);
+        CancelRequest(sourceRequest);
+    }
+
+    inline void Connect();
+
+    inline void OnStateChange(pa_context* c, void*)
+    {
+        switch (pa_context_get_state(c))
+        {
+        case PA_CONTEXT_UNCONNECTED:
+        case PA_CONTEXT_AUTHORIZING:
+        case PA_CONTEXT_SETTING_NAME:
+        case PA_CONTEXT_CONNECTING:
+            // Don't care
+            break;
+        case PA_CONTEXT_READY:
+        {
+            LOG("PulseAudio: Context is ready!");
+            Subscribe();
+            auto subscribeCallback = [](pa_context*, pa_subscription_event_type_t event, uint32_t index, void*)
+            {
+                // Sink inputs don't affect the default sink/source
+                if ((event & PA_SUBSCRIPTION_EVENT_FACILITY_MASK) != PA_SUBSCRIPTION_EVENT_SINK_INPUT)
+                    UpdateInfo();
+                if (!streamListeners.empty())
+                    OnStreamEvent(event, index);
+            };
+            pa_context_set_subscribe_callback(context, +subscribeCallback, nullptr);
 
-        bool ready = false;
-        auto stateCallback = [](pa_context* c, void* ready)
+            // Initialise info
+            UpdateInfo();
+            if (!streamListeners.empty())
+                RequestAllStreams();
+            break;
+        }
+        case PA_CONTEXT_FAILED:
+        case PA_CONTEXT_TERMINATED:
         {
-            switch (pa_context_get_state(c))
+            LOG("PulseAudio: Connection lost: " << pa_strerror(pa_context_errno(c)));
+            // The pending operations are cancelled without calling their callbacks
+            DropRequests();
+            // They might not exist anymore, once we're back
+            DropStreams(true);
+            pendingInfo = 0;
+            queueUpdate = false;
+            if (reconnectSource == 0)
             {
-            case PA_CONTEXT_TERMINATED:
-            case PA_CONTEXT_FAILED:
-            case PA_CONTEXT_UNCONNECTED: ASSERT(false, "PA Callback error!"); break;
-            case PA_CONTEXT_AUTHORIZING:
-            case PA_CONTEXT_SETTING_NAME:
-            case PA_CONTEXT_CONNECTING:
-                // Don't care
-                break;
-            case PA_CONTEXT_READY:
-                LOG("PulseAudio: Context is ready!");
-                *(bool*)ready = true;
-                break;
+                // Don't free the context inside of its own callback
+                auto reconnect = [](void*) -> gboolean
+                {
+                    reconnectSource = 0;
+                    Connect();
+                    return G_SOURCE_REMOVE;
+                };
+                reconnectSource = g_timeout_add(1000, +reconnect, nullptr);
             }
-        };
-        pa_context_set_state_callback(context, +stateCallback, &ready);
+            break;
+        }
+        }
+    }
 
-        while (!ready)
+    inline void Connect()
+    {
+        if (context)
+        {
+            // Disconnecting would report TERMINATED and schedule another reconnect
+            pa_context_set_state_callback(context, nullptr, nullptr);
+            pa_context_disconnect(context);
+            pa_context_unref(context);
+        }
+        context = pa_context_new(pa_glib_mainloop_get_api(mainLoop), "gBar PA context");
+        pa_context_set_state_callback(context, OnStateChange, nullptr);
+        // NOFAIL: Wait for the server to appear, instead of failing
+        int res = pa_context_connect(context, nullptr, (pa_context_flags_t)(PA_CONTEXT_NOAUTOSPAWN | PA_CONTEXT_NOFAIL), nullptr);
+        if (res < 0)
         {
-            pa_mainloop_iterate(mainLoop, 0, nullptr);
+            LOG("PulseAudio: pa_context_connect failed: " << pa_strerror(pa_context_errno(context)));
         }
+    }
 
-        // Subscribe to source and sink changes
-        auto subscribeSuccess = [](pa_context*, int success, void*)
+    inline void Init()
+    {
+        // Dispatched by the default main context, so nothing blocks or spins. The listeners get the info once the context is ready.
+        mainLoop = pa_glib_mainloop_new(nullptr);
+        Connect();
+    }
+
+    inline pa_volume_t DoubleToPAVolume(double value)
+    {
+        return (pa_volume_t)std::clamp(std::round(value * PA_VOLUME_NORM), (double)PA_VOLUME_MUTED, (double)PA_VOLUME_MAX);
+    }
+
+    inline void SendVolume(VolumeRequest& request, const pa_cvolume& volume)
+    {
+        if (request.inFlight)
         {
-            ASSERT(success >= 0, "Failed to subscribe to pulseaudio");
-        };
-        pa_operation* op = pa_context_subscribe(context, (pa_subscription_mask_t)(PA_SUBSCRIPTION_MASK_SINK | PA_SUBSCRIPTION_MASK_SOURCE),
-                                                +subscribeSuccess, nullptr);
-        pa_operation_ref(op);
-        pendingOperations.push_back(op);
-        FlushLoop();
+            request.queued = volume;
+            return;
+        }
+        if (!IsReady())
+            return;
 
-        auto subscribeCallback = [](pa_context*, pa_subscription_event_type_t type, uint32_t, void*)
+        auto onDone = [](pa_context*, int success, void* req)
         {
-            if (type & PA_SUBSCRIPTION_EVENT_CHANGE)
-                queueUpdate = true;
+            if (!success)
+            {
+                LOG("PulseAudio: Failed to set volume: " << pa_strerror(pa_context_errno(context)));
+            }
+            VolumeRequest& request = *(VolumeRequest*)req;
+            pa_operation_unref(request.inFlight);
+            request.inFlight = nullptr;
+            if (request.queued)
+            {
+                pa_cvolume next = *request.queued;
+                request.queued = {};
+                SendVolume(request, next);
+            }
         };
-        pa_context_set_subscribe_callback(context, +subscribeCallback, nullptr);
+        bool byName = request.index == PA_INVALID_INDEX;
+        switch (request.type)
+        {
+        case System::AudioStreamType::Sink:
+            request.inFlight = byName ? pa_context_set_sink_volume_by_name(context, defaultSink.c_str(), &volume, +onDone, &request)
+                                      : pa_context_set_sink_volume_by_index(context, request.index, &volume, +onDone, &request);
+            break;
+        case System::AudioStreamType::Source:
+            request.inFlight = byName ? pa_context_set_source_volume_by_name(context, defaultSource.c_str(), &volume, +onDone, &request)
+                                      : pa_context_set_source_volume_by_index(context, request.index, &volume, +onDone, &request);
+            break;
+        case System::AudioStreamType::SinkInput:
+            request.inFlight = pa_context_set_sink_input_volume(context, request.index, &volume, +onDone, &request);
+            break;
+        }
+    }
 
-        // Initialise info
-        UpdateInfo();
+    // Sets all channels, like pamixer does. Returns false, if we don't know the channels (yet).
+    inline bool MakeVolume(const pa_cvolume& current, double value, pa_cvolume& out)
+    {
+        if (current.channels == 0)
+            return false;
+        pa_cvolume_set(&out, current.channels, DoubleToPAVolume(value));
+        return true;
+    }
 
-        ASSERT(res >= 0, "pa_context_connect failed!");
+    inline void SendDefaultVolume(bool sink, double value)
+    {
+        pa_cvolume volume;
+        const std::string& name = sink ? defaultSink : defaultSource;
+        if (name.empty() || !MakeVolume(sink ? sinkVolume : sourceVolume, value, volume))
+        {
+            LOG("PulseAudio: No default " << (sink ? "sink" : "source") << " to set the volume of");
+            return;
+        }
+        SendVolume(sink ? sinkRequest : sourceRequest, volume);
+    }
+
+    inline void SendMute(bool sink, bool muted)
+    {
+        if (!IsReady())
+            return;
+        const std::string& name = sink ? defaultSink : defaultSource;
+        if (name.empty())
+        {
+            LOG("PulseAudio: No default " << (sink ? "sink" : "source") << " to mute");
+            return;
+        }
+        // We don't need the result, the change event updates the info
+        Issue(sink ? pa_context_set_sink_mute_by_name(context, name.c_str(), muted, nullptr, nullptr)
+                   : pa_context_set_source_mute_by_name(context, name.c_str(), muted, nullptr, nullptr));
     }
 
     inline void SetVolumeSink(double value)
     {
+        // Values above 1 are boost
         double valClamped = DoubleToVolumeWithMinMax(value);
-        // I'm too lazy to implement the c api for this. Since it will only be called when needed and doesn't pipe, it shouldn't be a problem to
-        // fallback for a command
         LOG("Audio: Set volume of sink: " << valClamped);
-        std::string cmd = "pamixer --allow-boost --set-volume " + std::to_string((uint32_t)(valClamped * 100));
         info.sinkVolume = std::clamp(value, 0., 1.); // We need to stay in 0/1 range
-        blockUpdate = true;
-        system(cmd.c_str());
+        SendDefaultVolume(true, valClamped);
     }
 
     inline void SetVolumeSource(double value)
     {
         double valClamped = std::clamp(value, 0., 1.);
-        // I'm too lazy to implement the c api for this. Since it will only be called when needed and doesn't pipe, it shouldn't be a problem to
-        // fallback for a command
         LOG("Audio: Set volume of source: " << valClamped);
-        std::string cmd = "pamixer --default-source --set-volume " + std::to_string((uint32_t)(valClamped * 100));
         info.sourceVolume = valClamped;
-        blockUpdate = true;
-        system(cmd.c_str());
+        SendDefaultVolume(false, valClamped);
     }
 
     inline void SetMutedSink(bool muted)
     {
-        if (muted)
-        {
-            LOG("Audio: Mute sink");
-            system("pamixer --mute");
-        }
-        else
-        {
-            LOG("Audio: Unmute sink");
-            system("pamixer --unmute");
-        }
+        LOG("Audio: " << (muted ? "Mute" : "Unmute") << " sink");
+        info.sinkMuted = muted;
+        SendMute(true, muted);
     }
 
     inline void SetMutedSource(bool muted)
     {
-        if (muted)
+        LOG("Audio: " << (muted ? "Mute" : "Unmute") << " source");
+        info.sourceMuted = muted;
+        SendMute(false, muted);
+    }
+
+    inline void SetStreamVolume(System::AudioStreamType type, uint32_t index, double value)
+    {
+        auto it = streams.find(StreamKey(type, index));
+        if (it == streams.end())
+            return;
+        Stream& stream = it->second;
+        stream.stream.volume = std::clamp(value, 0., 1.);
+        pa_cvolume volume;
+        if (MakeVolume(stream.volume, stream.stream.volume, volume))
+            SendVolume(stream.request, volume);
+    }
+
+    inline void SetStreamMuted(System::AudioStreamType type, uint32_t index, bool muted)
+    {
+        auto it = streams.find(StreamKey(type, index));
+        if (it == streams.end() || !IsReady())
+            return;
+        it->second.stream.muted = muted;
+        switch (type)
         {
-            LOG("Audio: Mute source");
-            system("pamixer --default-source --mute");
+        case System::AudioStreamType::Sink: Issue(pa_context_set_sink_mute_by_index(context, index, muted, nullptr, nullptr)); break;
+        case System::AudioStreamType::Source: Issue(pa_context_set_source_mute_by_index(context, index, muted, nullptr, nullptr)); break;
+        case System::AudioStreamType::SinkInput: Issue(pa_context_set_sink_input_mute(context, index, muted, nullptr, nullptr)); break;
         }
-        else
+    }
+
+    inline void SetDefaultStream(System::AudioStreamType type, uint32_t index)
+    {
+        auto it = streams.find(StreamKey(type, index));
+        if (it == streams.end() || !IsReady())
+            return;
+        const std::string& name = it->second.stream.name;
+        LOG("Audio: Set default " << (type == System::AudioStreamType::Sink ? "sink" : "source") << ": " << name);
+        switch (type)
         {
-            LOG("Audio: Unmute source");
-            system("pamixer --default-source --unmute");
+        case System::AudioStreamType::Sink: Issue(pa_context_set_default_sink(context, name.c_str(), nullptr, nullptr)); break;
+        case System::AudioStreamType::Source: Issue(pa_context_set_default_source(context, name.c_str(), nullptr, nullptr)); break;
+        default: LOG("PulseAudio: Only sinks and sources can be the default"); break;
         }
     }
 
     inline void Shutdown()
     {
-        pa_mainloop_free(mainLoop);
+        if (reconnectSource)
+        {
+            g_source_remove(reconnectSource);
+            reconnectSource = 0;
+        }
+        DropRequests();
+        DropStreams(false);
+        if (context)
+        {
+            pa_context_set_state_callback(context, nullptr, nullptr);
+            pa_context_disconnect(context);
+            pa_context_unref(context);
+            context = nullptr;
+        }
+        pa_glib_mainloop_free(mainLoop);
     }
 }
@@ -0,0 +1,211 @@
+#include "Sampler.h"
+#include "Common.h"
+#include "Config.h"
+#include "MainQueue.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Sampler
+{
+    // Same as the update interval of the bar
+    constexpr std::chrono::milliseconds sampleInterval{1000};
+
+    static std::thread samplerThread;
+    static std::mutex samplerMutex;
+    static std::condition_variable samplerWakeup;
+    static bool running = false;
+    static bool resampleRequested = false;
+    // Set by Resample(), so enabling a sensor doesn't wake the listeners
+    static bool notifyRequested = false;
+
+    static std::atomic<uint32_t> enabledSensors = 0;
+
+    static TripleBuffer<System::SensorSnapshot> snapshots;
+
+    struct Listener
+    {
+        uint32_t id;
+        std::function<void()> callback;
+    };
+    // Main thread only
+    static std::vector<Listener> resampleListeners;
+    static uint32_t nextListenerId = 0;
+
+    static void NotifyResampleListeners()
+    {
+        // Copy, since a callback may remove its listener
+        std::vector<Listener> listeners = resampleListeners;
+        for (auto& listener : listeners)
+        {
+            listener.callback();
+        }
+    }
+
+    static bool IsEnabled(uint32_t sensors, System::Sensor sensor)
+    {
+        return sensors & BIT((uint32_t)sensor);
+    }
+
+    static void Sample(System::SensorSnapshot& snapshot, uint32_t sensors, double dt)
+    {
+        bool cpu = IsEnabled(sensors, System::Sensor::CPU);
+        bool cpuCores = IsEnabled(sensors, System::Sensor::CPUCores);
+        if (cpu || cpuCores)
+        {
+            std::string_view procStat = System::ReadProcStat(cpuCores);
+            if (cpu)
+            {
+                snapshot.cpu = System::SampleCPUInfo(procStat);
+                snapshot.cpuTemp = System::SampleCPUTemp();
+            }
+            if (cpuCores)
+            {
+                System::SampleCPUCoresInfo(procStat, snapshot.cores);
+            }
+        }
+        if (IsEnabled(sensors, System::Sensor::RAM))
+        {
+            snapshot.ram = System::SampleRAMInfo();
+        }
+#if defined WITH_NVIDIA || defined WITH_AMD
+        if (IsEnabled(sensors, System::Sensor::GPU))
+        {
+            snapshot.gpu = System::SampleGPUInfo();
+        }
+        if (IsEnabled(sensors, System::Sensor::VRAM))
+        {
+            snapshot.vram = System::SampleVRAMInfo();
+        }
+#endif
+        if (IsEnabled(sensors, System::Sensor::Disk))
+        {
+            snapshot.disk = System::SampleDiskInfo();
+        }
+        if (IsEnabled(sensors, System::Sensor::Battery))
+        {
+            snapshot.batteryPercentage = System::SampleBatteryPercentage();
+            snapshot.batteryCharging = System::SampleBatteryCharging();
+        }
+        if (IsEnabled(sensors, System::Sensor::Network))
+        {
+            snapshot.networkUpBps = System::SampleNetworkBpsUpload(dt);
+            snapshot.networkDownBps = System::SampleNetworkBpsDownload(dt);
+        }
+        snapshot.sampledSensors = sensors;
+        snapshot.sequence++;
+    }
+
+    static void Run()
+    {
+        // The snapshot we're working on. The write buffer of the triple buffer is stale, so always copy the full snapshot over.
+        System::SensorSnapshot current{};
+        auto lastSample = std::chrono::steady_clock::now();
+
+        std::unique_lock<std::mutex> lock(samplerMutex);
+        while (running)
+        {
+            bool notify = notifyRequested;
+            resampleRequested = false;
+            notifyRequested = false;
+            lock.unlock();
+
+            auto now = std::chrono::steady_clock::now();
+            double dt = std::chrono::duration<double>(now - lastSample).count();
+            lastSample = now;
+
+            Sample(current, enabledSensors, dt);
+            snapshots.GetWriteBuffer() = current;
+            snapshots.Publish();
+            if (notify)
+            {
+                // Don't let the widgets wait for their next timer tick
+                PostToMain(NotifyResampleListeners);
+            }
+
+            lock.lock();
+            samplerWakeup.wait_until(lock, now + sampleInterval,
+                                     []()
+                                     {
+                                         return !running || resampleRequested;
+                                     });
+        }
+    }
+
+    void Enable(System::Sensor sensor)
+    {
+        uint32_t prevSensors = enabledSensors.fetch_or(BIT((uint32_t)sensor));
+        if (IsEnabled(prevSensors, sensor))
+        {
+            return;
+        }
+
+        std::scoped_lock<std::mutex> lock(samplerMutex);
+        if (!running)
+        {
+            LOG("Sampler: Starting sampler thread");
+            running = true;
+            samplerThread = std::thread(Run);
+        }
+        else
+        {
+            // Sample the new sensor right away
+            resampleRequested = true;
+            samplerWakeup.notify_one();
+        }
+    }
+
+    void Resample()
+    {
+        std::scoped_lock<std::mutex> lock(samplerMutex);
+        if (running)
+        {
+            resampleRequested = true;
+            notifyRequested = true;
+            samplerWakeup.notify_one();
+        }
+    }
+
+    uint32_t AddResampleListener(std::function<void()>&& callback)
+    {
+        uint32_t id = nextListenerId++;
+        resampleListeners.push_back({id, std::move(callback)});
+        return id;
+    }
+
+    void RemoveResampleListener(uint32_t id)
+    {
+        auto it = std::find_if(resampleListeners.begin(), resampleListeners.end(),
+                               [id](const Listener& listener)
+                               {
+                                   return listener.id == id;
+                               });
+        if (it != resampleListeners.end())
+        {
+            resampleListeners.erase(it);
+        }
+    }
+
+    const System::SensorSnapshot& Get()
+    {
+        return snapshots.GetReadBuffer();
+    }
+
+    void Shutdown()
+    {
+        {
+            std::scoped_lock<std::mutex> lock(samplerMutex);
+            if (!running)
+            {
+                return;
+            }
+            running = false;
+            samplerWakeup.notify_one();
+        }
+        samplerThread.join();
+        enabledSensors = 0;
+    }
+}
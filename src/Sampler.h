@@ -0,0 +1,55 @@
+#pragma once
+#include "System.h"
+
+#include <functional>
+#include <string_view>
+
+// Background thread, that gathers all enabled sensors in one pass and publishes them as an immutable snapshot.
+// The main thread only ever reads the newest snapshot and never touches procfs, sysfs, statvfs or NVML.
+namespace Sampler
+{
+    void Enable(System::Sensor sensor);
+    // Samples right away, instead of waiting for the next interval.
+    // Once the new snapshot is published, the resample listeners are run on the main thread.
+    void Resample();
+
+    // Main thread only
+    uint32_t AddResampleListener(std::function<void()>&& callback);
+    void RemoveResampleListener(uint32_t id);
+
+    // Main thread only
+    const System::SensorSnapshot& Get();
+
+    void Shutdown();
+}
+
+// The raw sensor reads behind the snapshot. They keep their previous sample (e.g. the CPU times) and their file buffers in statics,
+// so only the sampler thread may call them. Not part of the installed System.h on purpose.
+namespace System
+{
+    // Read once per sample and shared by the two CPU sensors. Only the per core sensor needs more than the first line.
+    std::string_view ReadProcStat(bool perCore);
+    CPUInfo SampleCPUInfo(std::string_view procStat);
+    // Fills in place, so the vectors are only allocated once
+    void SampleCPUCoresInfo(std::string_view procStat, CPUCoresInfo& out);
+    // Tctl
+    double SampleCPUTemp();
+
+    bool SampleBatteryCharging();
+    // Returns -1, if there is no battery
+    double SampleBatteryPercentage();
+
+    RAMInfo SampleRAMInfo();
+
+#if defined WITH_NVIDIA || defined WITH_AMD
+    GPUInfo SampleGPUInfo();
+    VRAMInfo SampleVRAMInfo();
+#endif
+
+    DiskInfo SampleDiskInfo();
+
+    // Bytes per second upload. dt is time since last call. Will always return 0 on first run
+    double SampleNetworkBpsUpload(double dt);
+    // Bytes per second download. dt is time since last call. Will always return 0 on first run
+    double SampleNetworkBpsDownload(double dt);
+}
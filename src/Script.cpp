@@ -0,0 +1,155 @@
+#include "Script.h"
+#include "Process.h"
+#include "Common.h"
+
+#include <glib.h>
+
+#include <memory>
+#include <unordered_map>
+
+namespace Script
+{
+    constexpr uint32_t restartDelayMS = 1000;
+    // A script, that never prints a newline, shouldn't grow the buffer forever
+    constexpr size_t maxLineLength = 64 * 1024;
+
+    struct Job
+    {
+        uint32_t id;
+        std::string command;
+        uint32_t intervalMS;
+        LineCallback onLine;
+
+        // 0, while the command is not running
+        uint32_t processId = 0;
+        guint timerSource = 0;
+        std::string buffer;
+    };
+    // Jobs are only deleted in Stop(), which cancels the process and the timer first
+    static std::unordered_map<uint32_t, std::unique_ptr<Job>> jobs;
+    static uint32_t nextId = 0;
+
+    static gboolean OnTimer(gpointer data);
+
+    static Job* Find(uint32_t id)
+    {
+        auto it = jobs.find(id);
+        return it == jobs.end() ? nullptr : it->second.get();
+    }
+
+    static void DeliverLine(Job& job, const std::string& line)
+    {
+        // Copy, since the callback may stop the job
+        LineCallback onLine = job.onLine;
+        onLine(line);
+    }
+
+    static void OnOutput(Job& job, std::string_view chunk)
+    {
+        job.buffer.append(chunk);
+
+        // Only the newest complete line is shown, the rest of a burst would be overwritten right away anyway
+        size_t lineEnd = job.buffer.rfind('\n');
+        if (lineEnd == std::string::npos)
+        {
+            if (job.buffer.size() > maxLineLength)
+            {
+                LOG("Script: Line too long, dropping output of \"" << job.command << "\"");
+                job.buffer.clear();
+            }
+            return;
+        }
+        size_t lineStart = lineEnd == 0 ? std::string::npos : job.buffer.rfind('\n', lineEnd - 1);
+        lineStart = lineStart == std::string::npos ? 0 : lineStart + 1;
+        std::string line = job.buffer.substr(lineStart, lineEnd - lineStart);
+        job.buffer.erase(0, lineEnd + 1);
+        DeliverLine(job, line);
+    }
+
+    static void OnExit(Job& job)
+    {
+        job.processId = 0;
+        if (job.intervalMS == 0)
+        {
+            // Don't spin on a script, that exits right away
+            job.timerSource = g_timeout_add(restartDelayMS, OnTimer, &job);
+        }
+
+        if (!job.buffer.empty())
+        {
+            // Last line without a newline
+            std::string line = std::move(job.buffer);
+            job.buffer.clear();
+            DeliverLine(job, line);
+        }
+    }
+
+    static void Spawn(Job& job)
+    {
+        uint32_t id = job.id;
+        Process::Options options;
+        options.onOutput = [id](std::string_view chunk)
+        {
+            if (Job* job = Find(id))
+                OnOutput(*job, chunk);
+        };
+        job.processId = Process::RunShell(
+            job.command,
+            [id](const Process::Result&)
+            {
+                if (Job* job = Find(id))
+                    OnExit(*job);
+            },
+            std::move(options));
+    }
+
+    static gboolean OnTimer(gpointer data)
+    {
+        Job& job = *(Job*)data;
+        if (job.intervalMS == 0)
+        {
+            job.timerSource = 0;
+            Spawn(job);
+            return G_SOURCE_REMOVE;
+        }
+
+        // Still in flight, skip this run
+        if (job.processId == 0)
+        {
+            Spawn(job);
+        }
+        return G_SOURCE_CONTINUE;
+    }
+
+    uint32_t Start(const std::string& command, uint32_t intervalMS, LineCallback&& onLine)
+    {
+        uint32_t id = nextId++;
+        auto job = std::make_unique<Job>();
+        job->id = id;
+        job->command = command;
+        job->intervalMS = intervalMS;
+        job->onLine = std::move(onLine);
+        Job& jobRef = *job;
+        jobs.emplace(id, std::move(job));
+
+        Spawn(jobRef);
+        if (intervalMS != 0)
+        {
+            jobRef.timerSource = g_timeout_add(intervalMS, OnTimer, &jobRef);
+        }
+        return id;
+    }
+
+    void Stop(uint32_t id)
+    {
+        Job* job = Find(id);
+        if (!job)
+            return;
+
+        if (job->timerSource)
+            g_source_remove(job->timerSource);
+        // Also terminates everything the script started
+        Process::Cancel(job->processId);
+        jobs.erase(id);
+    }
+}
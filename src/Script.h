@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Runs commands (through /bin/sh) in the background and passes their output to the main thread line by line.
+// stdout is read non-blocking from a GLib watch, so a hanging or flooding script never blocks the GTK thread.
+namespace Script
+{
+    // Called on the main thread with the newest complete line. Lines, that arrive in one burst, are collapsed to the last one.
+    using LineCallback = std::function<void(const std::string& line)>;
+
+    // intervalMS == 0: The command is kept running and restarted (after a second), if it exits.
+    // Otherwise the command is run every intervalMS. A run is skipped, while the previous one is still in flight.
+    // Returns an id for Stop().
+    uint32_t Start(const std::string& command, uint32_t intervalMS, LineCallback&& onLine);
+    // Terminates the command (and everything it started)
+    void Stop(uint32_t id);
+}
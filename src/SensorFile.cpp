@@ -0,0 +1,176 @@
+#include "SensorFile.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <mutex>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+static SensorFile::Counters counters;
+
+constexpr std::chrono::seconds minRetryDelay{5};
+constexpr std::chrono::seconds maxRetryDelay{5 * 60};
+
+static std::mutex registryMutex;
+static std::vector<SensorFile*> registry;
+
+SensorFile::SensorFile()
+{
+    std::scoped_lock<std::mutex> lock(registryMutex);
+    registry.push_back(this);
+}
+
+SensorFile::~SensorFile()
+{
+    Close();
+    std::scoped_lock<std::mutex> lock(registryMutex);
+    registry.erase(std::find(registry.begin(), registry.end(), this));
+}
+
+bool SensorFile::Open(const std::string& path)
+{
+    if (m_Fd >= 0)
+    {
+        close(m_Fd);
+    }
+    m_Fd = -1;
+    m_Path = path;
+    m_Configured = true;
+    m_RetryDelay = std::chrono::seconds(0);
+    if (m_Buffer.empty())
+    {
+        // Enough for nearly every sysfs file and /proc/meminfo. Bigger files grow the buffer on the first read.
+        m_Buffer.resize(4096);
+    }
+    return TryOpen();
+}
+
+bool SensorFile::TryOpen()
+{
+    m_Fd = open(m_Path.c_str(), O_RDONLY | O_CLOEXEC);
+    counters.opens++;
+    if (m_Fd < 0)
+    {
+        counters.failedOpens++;
+        m_RetryDelay = std::clamp(m_RetryDelay * 2, minRetryDelay, maxRetryDelay);
+        m_RetryAt = std::chrono::steady_clock::now() + m_RetryDelay;
+        return false;
+    }
+    m_RetryDelay = std::chrono::seconds(0);
+    return true;
+}
+
+void SensorFile::Close()
+{
+    if (m_Fd >= 0)
+    {
+        close(m_Fd);
+    }
+    m_Fd = -1;
+    m_Configured = false;
+}
+
+bool SensorFile::Reopen()
+{
+    close(m_Fd);
+    counters.reopens++;
+    return TryOpen();
+}
+
+std::string_view SensorFile::Read(size_t maxBytes)
+{
+    if (m_Fd < 0)
+    {
+        // Paths, that don't exist, usually never will. Don't pay a failing open() on every sample for them.
+        if (!m_Configured || std::chrono::steady_clock::now() < m_RetryAt || !TryOpen())
+        {
+            return {};
+        }
+    }
+
+    bool reopened = false;
+    size_t size = 0;
+    while (true)
+    {
+        size_t limit = std::min(m_Buffer.size(), maxBytes);
+        ssize_t bytesRead = pread(m_Fd, m_Buffer.data() + size, limit - size, size);
+        counters.reads++;
+        if (bytesRead < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if ((errno == ENODEV || errno == ESTALE) && !reopened)
+            {
+                // The device has been replaced (e.g. hwmon or drm reprobe). Try the same path again.
+                reopened = true;
+                size = 0;
+                if (Reopen())
+                {
+                    continue;
+                }
+            }
+            counters.failedReads++;
+            return {};
+        }
+        if (bytesRead == 0)
+        {
+            break;
+        }
+        size += bytesRead;
+        if (size == maxBytes)
+        {
+            break;
+        }
+        if (size == m_Buffer.size())
+        {
+            // File is bigger than our buffer. Grow and read again from the start, so we get a consistent view of the file.
+            m_Buffer.resize(m_Buffer.size() * 2);
+            size = 0;
+        }
+    }
+    return std::string_view(m_Buffer.data(), size);
+}
+
+bool SensorFile::ReadUInt(uint64_t& out)
+{
+    std::string_view content = Read();
+    size_t idx = 0;
+    while (idx < content.size() && (content[idx] == ' ' || content[idx] == '\t'))
+    {
+        idx++;
+    }
+    if (idx == content.size() || content[idx] < '0' || content[idx] > '9')
+    {
+        return false;
+    }
+    out = 0;
+    for (; idx < content.size() && content[idx] >= '0' && content[idx] <= '9'; idx++)
+    {
+        out = out * 10 + (content[idx] - '0');
+    }
+    return true;
+}
+
+std::string_view SensorFile::ReadLine()
+{
+    std::string_view content = Read();
+    return content.substr(0, content.find('\n'));
+}
+
+void SensorFile::CloseAll()
+{
+    std::scoped_lock<std::mutex> lock(registryMutex);
+    for (SensorFile* file : registry)
+    {
+        file->Close();
+    }
+}
+
+const SensorFile::Counters& SensorFile::GetCounters()
+{
+    return counters;
+}
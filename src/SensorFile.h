@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A procfs/sysfs file, that is opened once and then re-read with pread at offset 0.
+// This saves the open/close syscall pair on every sample. If the underlying device went away (ENODEV/ESTALE), the file is transparently
+// reopened. A file, that can't be opened (e.g. no cpufreq in a VM), is only retried with an increasing delay, or when it is opened again
+// after a config reload.
+class SensorFile
+{
+public:
+    struct Counters
+    {
+        std::atomic<uint64_t> opens = 0;
+        std::atomic<uint64_t> failedOpens = 0;
+        std::atomic<uint64_t> reopens = 0;
+        std::atomic<uint64_t> reads = 0;
+        std::atomic<uint64_t> failedReads = 0;
+    };
+
+    SensorFile();
+    ~SensorFile();
+
+    SensorFile(const SensorFile&) = delete;
+    SensorFile& operator=(const SensorFile&) = delete;
+
+    // Sets the path and opens the file. Returns whether the file could be opened.
+    bool Open(const std::string& path);
+    void Close();
+
+    // Whether Open() has been called since construction or the last Close().
+    bool IsConfigured() const { return m_Configured; }
+    bool IsOpen() const { return m_Fd >= 0; }
+
+    // Reads the whole file, or only its first maxBytes. The view is valid until the next call to Read(). Returns an empty view on failure.
+    std::string_view Read(size_t maxBytes = SIZE_MAX);
+    // Parses the first number of the file. Returns false on failure
+    bool ReadUInt(uint64_t& out);
+    // Returns the first line of the file
+    std::string_view ReadLine();
+
+    // Closes all sensor files, so they're reopened with the current config. Sampling must not run while this is called.
+    static void CloseAll();
+
+    static const Counters& GetCounters();
+
+private:
+    bool TryOpen();
+    bool Reopen();
+
+    std::string m_Path;
+    int m_Fd = -1;
+    bool m_Configured = false;
+    // When a failed open is retried. The delay doubles with each failure.
+    std::chrono::steady_clock::time_point m_RetryAt;
+    std::chrono::seconds m_RetryDelay{0};
+    // Grows to the size of the biggest read and is then reused.
+    std::vector<char> m_Buffer;
+};
@@ -3,18 +3,26 @@
 #include "NvidiaGPU.h"
 #include "AMDGPU.h"
 #include "PulseAudio.h"
+#include "PeakMeter.h"
 #include "Workspaces.h"
 #include "Config.h"
 #include "SNI.h"
 #include "Wayland.h"
-
+#include "Sampler.h"
+#include "SensorFile.h"
+#include "ProcParse.h"
+#include "Process.h"
+#include "MainQueue.h"
+#include "BlueZ.h"
+
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
-#include <mutex>
 #include <string>
 #include <sstream>
 #include <iomanip>
-#include <thread>
+#include <memory>
 
 #include <gio/gio.h>
 
@@ -26,152 +34,195 @@
 
 namespace System
 {
-    struct CPUTimestamp
+    static ProcParse::CPUTimestamp curCPUTime;
+    static ProcParse::CPUTimestamp prevCPUTime;
+
+    std::string_view ReadProcStat(bool perCore)
     {
-        size_t total = 0;
-        size_t idle = 0;
-    };
+        static SensorFile procstat;
+        if (!procstat.IsConfigured())
+        {
+            ASSERT(procstat.Open("/proc/stat"), "Cannot open /proc/stat");
+        }
+        if (perCore)
+        {
+            return procstat.Read();
+        }
+        // The aggregate "cpu " line is always the first line, so only read that far instead of the whole file (the intr line alone
+        // can be several KiB). Ten 64-bit counters fit easily.
+        return procstat.Read(512);
+    }
 
-    static CPUTimestamp curCPUTime;
-    static CPUTimestamp prevCPUTime;
+    CPUInfo SampleCPUInfo(std::string_view content)
+    {
+        using ProcParse::CPUField;
+        ProcParse::CPUTimestamp timestamp;
+        if (!ProcParse::ParseCPU(content, timestamp))
+        {
+            LOG("Error: Unexpected format of /proc/stat");
+            return {};
+        }
+        prevCPUTime = curCPUTime;
+        curCPUTime = timestamp;
 
-    double GetCPUUsage()
+        // Get diffs and percentage of each split
+        double diffTotal = curCPUTime.Total() - prevCPUTime.Total();
+        if (diffTotal == 0)
+        {
+            return {};
+        }
+        auto diff = [&](CPUField field)
+        {
+            return (double)(curCPUTime.Get(field) - prevCPUTime.Get(field)) / diffTotal;
+        };
+        CPUInfo out;
+        out.usage = 1 - diff(CPUField::Idle);
+        out.iowait = diff(CPUField::IOWait);
+        out.irq = diff(CPUField::IRQ) + diff(CPUField::SoftIRQ);
+        out.steal = diff(CPUField::Steal);
+        return out;
+    }
+
+    uint32_t GetCPUCoreCount()
+    {
+        static uint32_t numCores = std::max(sysconf(_SC_NPROCESSORS_CONF), 1l);
+        return numCores;
+    }
+
+    void SampleCPUCoresInfo(std::string_view content, CPUCoresInfo& out)
     {
-        // Gather curCPUTime
-        std::ifstream procstat("/proc/stat");
-        ASSERT(procstat.is_open(), "Cannot open /proc/stat");
+        static bool initialized = false;
+        static std::vector<std::unique_ptr<SensorFile>> frequencyFiles;
+        // Flat arrays, so the deltas below can be vectorized
+        static std::vector<uint64_t> curTotal, curIdle;
+        static std::vector<uint64_t> prevTotal, prevIdle;
 
-        std::string curLine;
-        while (std::getline(procstat, curLine))
+        uint32_t numCores = GetCPUCoreCount();
+        if (!initialized)
         {
-            if (curLine.find("cpu ") != std::string::npos)
+            initialized = true;
+            curTotal.resize(numCores);
+            curIdle.resize(numCores);
+            prevTotal.resize(numCores);
+            prevIdle.resize(numCores);
+            frequencyFiles.resize(numCores);
+            for (uint32_t i = 0; i < numCores; i++)
             {
-                // Found it
-                std::stringstream lineStr(curLine.substr(5));
-                std::string curLine;
-                uint32_t idx = 1;
-                size_t total = 0;
-                size_t idle = 0;
-                while (std::getline(lineStr, curLine, ' '))
-                {
-                    if (idx == 4)
-                    {
-                        // Fourth col is idle
-                        idle = atoi(curLine.c_str());
-                    }
-                    total += atoi(curLine.c_str());
-                    idx++;
-                }
-                prevCPUTime = curCPUTime;
-                curCPUTime.total = total;
-                curCPUTime.idle = idle;
-                break;
+                frequencyFiles[i] = std::make_unique<SensorFile>();
             }
         }
+        out.usage.resize(numCores);
+        out.frequencyMHz.resize(numCores);
+
+        std::swap(curTotal, prevTotal);
+        std::swap(curIdle, prevIdle);
+        ProcParse::ParseCPUCores(content, numCores, curTotal.data(), curIdle.data());
+
+        const uint64_t* curTotalData = curTotal.data();
+        const uint64_t* curIdleData = curIdle.data();
+        const uint64_t* prevTotalData = prevTotal.data();
+        const uint64_t* prevIdleData = prevIdle.data();
+        float* usage = out.usage.data();
+        for (uint32_t i = 0; i < numCores; i++)
+        {
+            // Signed, so a core that went offline is 0 instead of wrapping around
+            float diffTotal = (int64_t)(curTotalData[i] - prevTotalData[i]);
+            float diffIdle = (int64_t)(curIdleData[i] - prevIdleData[i]);
+            usage[i] = diffTotal > 0 ? 1.f - diffIdle / diffTotal : 0.f;
+        }
 
-        // Get diffs and percentage of idle time
-        size_t diffTotal = curCPUTime.total - prevCPUTime.total;
-        size_t diffIdle = curCPUTime.idle - prevCPUTime.idle;
-        return 1 - ((double)diffIdle / (double)diffTotal);
+        for (uint32_t i = 0; i < numCores; i++)
+        {
+            // scaling_cur_freq is in kHz
+            uint64_t frequencyKHz = 0;
+            // Closed again by reload-config, like every other sensor file
+            if (!frequencyFiles[i]->IsConfigured())
+            {
+                frequencyFiles[i]->Open("/sys/devices/system/cpu/cpu" + std::to_string(i) + "/cpufreq/scaling_cur_freq");
+            }
+            frequencyFiles[i]->ReadUInt(frequencyKHz);
+            out.frequencyMHz[i] = (float)frequencyKHz / 1000.f;
+        }
     }
 
-    double GetCPUTemp()
+    double SampleCPUTemp()
     {
-        std::ifstream tempFile(Config::Get().cpuThermalZone);
-        if (!tempFile.is_open())
+        static SensorFile tempFile;
+        if (!tempFile.IsConfigured())
+        {
+            tempFile.Open(Config::Get().cpuThermalZone);
+        }
+        uint64_t intTemp;
+        if (!tempFile.ReadUInt(intTemp))
         {
             return 0.f;
         }
-        std::string tempStr;
-        std::getline(tempFile, tempStr);
-        uint32_t intTemp = atoi(tempStr.c_str());
         double temp = (double)intTemp / 1000;
         return temp;
     }
 
-    bool IsBatteryCharging()
+    bool SampleBatteryCharging()
     {
-        std::ifstream batteryStatus(Config::Get().batteryFolder + "/status");
-        if (batteryStatus.is_open())
+        static SensorFile batteryStatus;
+        if (!batteryStatus.IsConfigured())
         {
-            std::string status;
-            std::getline(batteryStatus, status);
-            if (status == "Charging" || status == "Full")
-            {
-                return true;
-            }
-            else
-            {
-                return false;
-            }
+            batteryStatus.Open(Config::Get().batteryFolder + "/status");
         }
-        return false;
+        std::string_view status = batteryStatus.ReadLine();
+        return status == "Charging" || status == "Full";
     }
 
-    double GetBatteryPercentage()
+    double SampleBatteryPercentage()
     {
-        std::ifstream fullChargeFile(Config::Get().batteryFolder + "/charge_full");
-        std::ifstream currentChargeFile(Config::Get().batteryFolder + "/charge_now");
-        if (fullChargeFile.is_open() && currentChargeFile.is_open())
+        static SensorFile fullChargeFile;
+        static SensorFile currentChargeFile;
+        static SensorFile capacityFile;
+        if (!fullChargeFile.IsConfigured())
+        {
+            fullChargeFile.Open(Config::Get().batteryFolder + "/charge_full");
+            currentChargeFile.Open(Config::Get().batteryFolder + "/charge_now");
+            capacityFile.Open(Config::Get().batteryFolder + "/capacity");
+        }
+
+        uint64_t intFullCharge;
+        uint64_t intCurrentCharge;
+        if (fullChargeFile.ReadUInt(intFullCharge) && currentChargeFile.ReadUInt(intCurrentCharge))
         {
-            std::string fullChargeStr;
-            std::string currentChargeStr;
-            std::getline(fullChargeFile, fullChargeStr);
-            std::getline(currentChargeFile, currentChargeStr);
-            uint32_t intFullCharge = atoi(fullChargeStr.c_str());
-            uint32_t intCurrentCharge = atoi(currentChargeStr.c_str());
             return ((double)intCurrentCharge / (double)intFullCharge);
         }
 
         // Try capacity
-        std::ifstream capacityFile(Config::Get().batteryFolder + "/capacity");
-        if (capacityFile.is_open())
+        uint64_t intCapacity;
+        if (capacityFile.ReadUInt(intCapacity))
         {
-            std::string capacityStr;
-            std::getline(capacityFile, capacityStr);
-            uint32_t intCapacity = atoi(capacityStr.c_str());
             return (double)intCapacity / 100.0;
         }
 
-        // TODO: This is the wrong place to do this, since we don't know whether it is actually disabled.
-        // A RuntimeConfig would be better, but it works for now.
-        LOG("Couldn't open battery charge files! Disabling battery widget.")
         return -1;
     }
 
-    RAMInfo GetRAMInfo()
+    void CheckBattery()
     {
-        RAMInfo out{};
-        std::ifstream procstat("/proc/meminfo");
-        ASSERT(procstat.is_open(), "Cannot open /proc/meminfo");
+        if (SampleBatteryPercentage() < 0)
+        {
+            LOG("Couldn't open battery charge files! Disabling battery widget.");
+            RuntimeConfig::Get().hasBattery = false;
+        }
+    }
 
-        std::string curLine;
-        while (std::getline(procstat, curLine))
+    RAMInfo SampleRAMInfo()
+    {
+        static SensorFile meminfo;
+        if (!meminfo.IsConfigured())
         {
-            if (curLine.find("MemTotal: ") != std::string::npos)
-            {
-                // Found total
-                std::string_view withoutMemTotal = std::string_view(curLine).substr(10);
-                size_t begNum = withoutMemTotal.find_first_not_of(' ');
-                std::string_view totalKiBStr = withoutMemTotal.substr(begNum, withoutMemTotal.find_last_of(' ') - begNum);
-                uint32_t totalKiB = std::stoi(std::string(totalKiBStr));
-                out.totalGiB = (double)totalKiB / (1024 * 1024);
-            }
-            else if (curLine.find("MemAvailable: ") != std::string::npos)
-            {
-                // Found available
-                std::string_view withoutMemAvail = std::string_view(curLine).substr(14);
-                size_t begNum = withoutMemAvail.find_first_not_of(' ');
-                std::string_view availKiBStr = withoutMemAvail.substr(begNum, withoutMemAvail.find_last_of(' ') - begNum);
-                uint32_t availKiB = std::stoi(std::string(availKiBStr));
-                out.freeGiB = (double)availKiB / (1024 * 1024);
-            }
+            ASSERT(meminfo.Open("/proc/meminfo"), "Cannot open /proc/meminfo");
         }
-        return out;
+
+        return ProcParse::ParseMemInfo(meminfo.Read());
     }
 
 #if defined WITH_NVIDIA || defined WITH_AMD
-    GPUInfo GetGPUInfo()
+    GPUInfo SampleGPUInfo()
     {
 #ifdef WITH_NVIDIA
         if (RuntimeConfig::Get().hasNvidia)
@@ -196,7 +247,7 @@ namespace System
         return {};
     }
 
-    VRAMInfo GetVRAMInfo()
+    VRAMInfo SampleVRAMInfo()
     {
 #ifdef WITH_NVIDIA
         if (RuntimeConfig::Get().hasNvidia)
@@ -222,7 +273,7 @@ namespace System
     }
 #endif
 
-    DiskInfo GetDiskInfo()
+    DiskInfo SampleDiskInfo()
     {
         struct statvfs stat;
         std::string partition = Config::Get().diskPartition;
@@ -236,217 +287,167 @@ namespace System
         return out;
     }
 
+    void EnableSensor(Sensor sensor)
+    {
+        Sampler::Enable(sensor);
+    }
+
+    const SensorSnapshot& GetSensorSnapshot()
+    {
+        return Sampler::Get();
+    }
+
+    void ResampleSensors()
+    {
+        Sampler::Resample();
+    }
+
+    uint32_t AddSensorResampleCallback(std::function<void()>&& callback)
+    {
+        return Sampler::AddResampleListener(std::move(callback));
+    }
+
+    void RemoveSensorResampleCallback(uint32_t id)
+    {
+        Sampler::RemoveResampleListener(id);
+    }
+
+    static const SensorSnapshot& GetSnapshotWith(Sensor sensor)
+    {
+        EnableSensor(sensor);
+        return GetSensorSnapshot();
+    }
+    double GetCPUUsage()
+    {
+        return GetSnapshotWith(Sensor::CPU).cpu.usage;
+    }
+    double GetCPUTemp()
+    {
+        return GetSnapshotWith(Sensor::CPU).cpuTemp;
+    }
+    bool IsBatteryCharging()
+    {
+        return GetSnapshotWith(Sensor::Battery).batteryCharging;
+    }
+    double GetBatteryPercentage()
+    {
+        return GetSnapshotWith(Sensor::Battery).batteryPercentage;
+    }
+    RAMInfo GetRAMInfo()
+    {
+        return GetSnapshotWith(Sensor::RAM).ram;
+    }
+#if defined WITH_NVIDIA || defined WITH_AMD
+    GPUInfo GetGPUInfo()
+    {
+        return GetSnapshotWith(Sensor::GPU).gpu;
+    }
+    VRAMInfo GetVRAMInfo()
+    {
+        return GetSnapshotWith(Sensor::VRAM).vram;
+    }
+#endif
+    DiskInfo GetDiskInfo()
+    {
+        return GetSnapshotWith(Sensor::Disk).disk;
+    }
+    double GetNetworkBpsUpload(double)
+    {
+        return GetSnapshotWith(Sensor::Network).networkUpBps;
+    }
+    double GetNetworkBpsDownload(double)
+    {
+        return GetSnapshotWith(Sensor::Network).networkDownBps;
+    }
+
 #ifdef WITH_BLUEZ
     void InitBluetooth()
     {
-        // Try connecting to d-bus and org.bluez
-        GDBusConnection* connection = g_bus_get_sync(G_BUS_TYPE_SYSTEM, nullptr, nullptr);
-        if (!connection)
-        {
-            LOG("Can't connect to d-bus! Disabling Bluetooth!");
-            // dbus not found, disable bluetooth
-            RuntimeConfig::Get().hasBlueZ = false;
-        }
-
-        GError* err = nullptr;
-        GVariant* objects = g_dbus_connection_call_sync(connection, "org.bluez", "/", "org.freedesktop.DBus.ObjectManager", "GetManagedObjects",
-                                                        nullptr, G_VARIANT_TYPE("(a{oa{sa{sv}}})"), G_DBUS_CALL_FLAGS_NONE, -1, nullptr, &err);
-        if (!objects)
+        if (!BlueZ::Init())
         {
-            LOG("Can't connect to BlueZ d-bus! Disabling Bluetooth!");
-            LOG(err->message);
-            g_error_free(err);
             // Not found, disable bluetooth
             RuntimeConfig::Get().hasBlueZ = false;
         }
     }
-    BluetoothInfo GetBluetoothInfo()
+    const BluetoothInfo& GetBluetoothInfo()
     {
-        BluetoothInfo out{};
         if (!RuntimeConfig::Get().hasBlueZ)
         {
             LOG("Error: GetBluetoothInfo called, but bluetooth isn't available");
-            return out;
-        }
-        // Init D-Bus
-        GDBusConnection* connection = g_bus_get_sync(G_BUS_TYPE_SYSTEM, nullptr, nullptr);
-        ASSERT(connection, "Failed to connect to d-bus!");
-
-        GError* err = nullptr;
-        GVariant* objects = g_dbus_connection_call_sync(connection, "org.bluez", "/", "org.freedesktop.DBus.ObjectManager", "GetManagedObjects",
-                                                        nullptr, G_VARIANT_TYPE("(a{oa{sa{sv}}})"), G_DBUS_CALL_FLAGS_NONE, -1, nullptr, &err);
-        if (!objects)
-        {
-            LOG(err->message);
-            g_error_free(err);
-            exit(-1);
-        }
-
-        // First array
-        GVariantIter* topArray;
-        g_variant_get(objects, "(a{oa{sa{sv}}})", &topArray);
-
-        // Iterate the objects
-        GVariantIter* objectDescs;
-        while (g_variant_iter_next(topArray, "{oa{sa{sv}}}", NULL, &objectDescs))
-        {
-            // Iterate the descs
-            char* type = nullptr;
-            GVariantIter* propIter;
-            while (g_variant_iter_next(objectDescs, "{sa{sv}}", &type, &propIter))
-            {
-                if (strstr(type, "org.bluez.Adapter1"))
-                {
-                    std::string adapterName;
-                    bool powered = false;
-
-                    // This is a controller/adapter -> The "host"
-                    char* str = nullptr;
-                    GVariant* var = nullptr;
-                    while (g_variant_iter_next(propIter, "{sv}", &str, &var))
-                    {
-                        if (strstr(str, "Name"))
-                        {
-                            const char* name = g_variant_get_string(var, nullptr);
-                            // Copy it for us
-                            adapterName = name;
-                        }
-                        else if (strstr(str, "Powered"))
-                        {
-                            powered = g_variant_get_boolean(var);
-                        }
-                        g_free(str);
-                        g_variant_unref(var);
-                    }
-                    if (powered)
-                    {
-                        out.defaultController = std::move(adapterName);
-                    }
-                }
-                else if (strstr(type, "org.bluez.Device1"))
-                {
-                    std::string deviceMac;
-                    std::string deviceName;
-                    std::string deviceType;
-                    bool connected = false;
-                    bool paired = false;
-
-                    // This is a device -> One "client"
-                    char* str = nullptr;
-                    GVariant* var = nullptr;
-                    while (g_variant_iter_next(propIter, "{sv}", &str, &var))
-                    {
-                        if (strcmp(str, "Address") == 0)
-                        {
-                            const char* mac = g_variant_get_string(var, nullptr);
-                            // Copy it for us
-                            deviceMac = mac;
-                        }
-                        else if (strstr(str, "Name"))
-                        {
-                            const char* name = g_variant_get_string(var, nullptr);
-                            // Copy it for us
-                            deviceName = name;
-                        }
-                        else if (strstr(str, "Icon"))
-                        {
-                            const char* icon = g_variant_get_string(var, nullptr);
-                            // Copy it for us
-                            deviceType = icon;
-                        }
-                        else if (strstr(str, "Connected"))
-                        {
-                            connected = g_variant_get_boolean(var);
-                        }
-                        else if (strstr(str, "Paired"))
-                        {
-                            paired = g_variant_get_boolean(var);
-                        }
-                        g_free(str);
-                        g_variant_unref(var);
-                    }
-                    out.devices.push_back(BluetoothDevice{connected, paired, std::move(deviceMac), std::move(deviceName), std::move(deviceType)});
-                }
-                g_variant_iter_free(propIter);
-                g_free(type);
-            }
-            g_variant_iter_free(objectDescs);
         }
-
-        g_variant_iter_free(topArray);
-        g_variant_unref(objects);
-
-        return out;
+        return BlueZ::GetInfo();
     }
-
-    static Process btctlProcess{-1};
-    void StartBTScan()
+    uint32_t AddBluetoothChangeCallback(std::function<void()>&& callback, bool rssiChanges)
     {
-        StopBTScan();
-        btctlProcess = OpenProcess("/bin/sh -c \"bluetoothctl scan on\"");
+        return BlueZ::AddListener(std::move(callback), rssiChanges);
     }
-    void StopBTScan()
+    void RemoveBluetoothChangeCallback(uint32_t id)
     {
-        if (btctlProcess.pid != -1)
-        {
-            // Ctrl-C stops bluetoothctl
-            kill(btctlProcess.pid, SIGINT);
-            btctlProcess = {-1};
-        }
+        BlueZ::RemoveListener(id);
     }
 
-    void ConnectBTDevice(BluetoothDevice& device, std::function<void(bool, BluetoothDevice&)> onFinish)
+    static bool btScanning = false;
+    void StartBTScan()
     {
-        auto thread = [&, mac = device.mac, onFinish]()
-        {
-            // 1. Pair
-            if (!device.paired)
-            {
-                int success = system(("bluetoothctl pair " + mac).c_str());
-                if (success != 0)
-                {
-                    onFinish(false, device);
-                    return;
-                }
-            }
-            // 2. Connect
-            if (!device.connected)
+        if (btScanning)
+            return;
+        btScanning = true;
+        BlueZ::StartDiscovery(
+            [](const BlueZ::Result& result)
             {
-                int success = system(("bluetoothctl connect " + mac).c_str());
-                if (success != 0)
+                if (!result.error.empty())
                 {
-                    onFinish(false, device);
-                    return;
+                    LOG("Bluetooth: Failed to start discovery: " << result.error << ": " << result.message);
                 }
-            }
-            onFinish(true, device);
-        };
-        std::thread worker(thread);
-        worker.detach();
+            });
     }
-    void DisconnectBTDevice(BluetoothDevice& device, std::function<void(bool, BluetoothDevice&)> onFinish)
+    void StopBTScan()
     {
-        auto thread = [&, mac = device.mac, onFinish]()
-        {
-            // 1. Disconnect
-            if (device.connected)
+        if (!btScanning)
+            return;
+        btScanning = false;
+        BlueZ::StopDiscovery(
+            [](const BlueZ::Result& result)
             {
-                int success = system(("bluetoothctl disconnect " + mac).c_str());
-                if (success != 0)
+                if (!result.error.empty())
                 {
-                    onFinish(false, device);
-                    return;
+                    LOG("Bluetooth: Failed to stop discovery: " << result.error << ": " << result.message);
                 }
-            }
-            onFinish(true, device);
-        };
-        std::thread worker(thread);
-        worker.detach();
+            });
+    }
+
+    uint32_t ConnectBTDevice(const BluetoothDevice& device, std::function<void(bool success)>&& onFinish)
+    {
+        return BlueZ::Connect(device.mac,
+                              [mac = device.mac, onFinish = std::move(onFinish)](const BlueZ::Result& result)
+                              {
+                                  if (!result.error.empty())
+                                  {
+                                      LOG("Bluetooth: Failed to connect " << mac << ": " << result.error << ": " << result.message);
+                                  }
+                                  onFinish(result.error.empty());
+                              });
+    }
+    uint32_t DisconnectBTDevice(const BluetoothDevice& device, std::function<void(bool success)>&& onFinish)
+    {
+        return BlueZ::Disconnect(device.mac,
+                                 [mac = device.mac, onFinish = std::move(onFinish)](const BlueZ::Result& result)
+                                 {
+                                     if (!result.error.empty())
+                                     {
+                                         LOG("Bluetooth: Failed to disconnect " << mac << ": " << result.error << ": " << result.message);
+                                     }
+                                     onFinish(result.error.empty());
+                                 });
+    }
+    void CancelBTRequest(uint32_t id)
+    {
+        BlueZ::Cancel(id);
     }
 
     void OpenBTWidget()
     {
-        OpenProcess("/bin/sh -c \"gBar bluetooth\"");
+        Process::Run({"gBar", "bluetooth"});
     }
 
     std::string BTTypeToIcon(const BluetoothDevice& dev)
@@ -475,6 +476,14 @@ namespace System
     {
         return PulseAudio::GetInfo();
     }
+    uint32_t AddAudioChangeCallback(std::function<void(const AudioInfo&)>&& callback)
+    {
+        return PulseAudio::AddListener(std::move(callback));
+    }
+    void RemoveAudioChangeCallback(uint32_t id)
+    {
+        PulseAudio::RemoveListener(id);
+    }
     void SetVolumeSink(double volume)
     {
         PulseAudio::SetVolumeSink(volume);
@@ -483,7 +492,6 @@ namespace System
     {
         PulseAudio::SetVolumeSource(volume);
     }
-
     void SetMutedSink(bool muted)
     {
         PulseAudio::SetMutedSink(muted);
@@ -492,6 +500,35 @@ namespace System
     {
         PulseAudio::SetMutedSource(muted);
     }
+    uint32_t AddAudioStreamCallback(std::function<void(const AudioStream&, bool)>&& callback)
+    {
+        return PulseAudio::AddStreamListener(std::move(callback));
+    }
+    void RemoveAudioStreamCallback(uint32_t id)
+    {
+        PulseAudio::RemoveStreamListener(id);
+    }
+    void SetAudioStreamVolume(AudioStreamType type, uint32_t index, double volume)
+    {
+        PulseAudio::SetStreamVolume(type, index, volume);
+    }
+    void SetAudioStreamMuted(AudioStreamType type, uint32_t index, bool muted)
+    {
+        PulseAudio::SetStreamMuted(type, index, muted);
+    }
+    void SetDefaultAudioStream(AudioStreamType type, uint32_t index)
+    {
+        PulseAudio::SetDefaultStream(type, index);
+    }
+
+    uint32_t AddAudioLevelCallback(std::function<void(const AudioLevel&)>&& callback)
+    {
+        return PeakMeter::AddListener(std::move(callback));
+    }
+    void RemoveAudioLevelCallback(uint32_t id)
+    {
+        PeakMeter::RemoveListener(id);
+    }
 
 #ifdef WITH_WORKSPACES
     void PollWorkspaces(const std::string& monitor, uint32_t numWorkspaces)
@@ -506,6 +543,10 @@ namespace System
     {
         return Workspaces::GetMaxUsedWorkspace();
     }
+    bool SetWorkspaceChangeCallback(std::function<void()>&& callback)
+    {
+        return Workspaces::SetOnChange(std::move(callback));
+    }
     void GotoWorkspace(uint32_t workspace)
     {
         return Workspaces::Goto(workspace);
@@ -543,17 +584,24 @@ namespace System
         }
     }
 
-    double GetNetworkBpsCommon(double dt, uint64_t& prevBytes, const std::string& deviceFile)
+    double GetNetworkBpsCommon(double dt, uint64_t& prevBytes, SensorFile& deviceFile, const char* statistic)
     {
         if (!RuntimeConfig::Get().hasNet)
         {
             return 0.f;
         }
-        std::ifstream bytes(deviceFile);
-        std::string bytesStr;
-        std::getline(bytes, bytesStr);
+        if (!deviceFile.IsConfigured())
+        {
+            // Apparently /sys/class/net/.../statistics/[t/r]x_bytes is valid for all net devices under Linux
+            // https://www.kernel.org/doc/Documentation/ABI/testing/sysfs-class-net-statistics
+            deviceFile.Open("/sys/class/net/" + Config::Get().networkAdapter + "/statistics/" + statistic);
+        }
 
-        uint64_t curBytes = std::stoull(bytesStr);
+        uint64_t curBytes;
+        if (!deviceFile.ReadUInt(curBytes))
+        {
+            return 0.f;
+        }
 
         if (prevBytes == UINT64_MAX)
         {
@@ -569,85 +617,67 @@ namespace System
         }
     }
 
-    double GetNetworkBpsUpload(double dt)
+    double SampleNetworkBpsUpload(double dt)
     {
         // Better safe than sorry. Isn't 32bit max only a few GB?
         static uint64_t prevUploadBytes = UINT64_MAX;
-        // Apparently /sys/class/net/.../statistics/[t/r]x_bytes is valid for all net devices under Linux
-        // https://www.kernel.org/doc/Documentation/ABI/testing/sysfs-class-net-statistics
-        return GetNetworkBpsCommon(dt, prevUploadBytes, "/sys/class/net/" + Config::Get().networkAdapter + "/statistics/tx_bytes");
+        static SensorFile txBytes;
+        return GetNetworkBpsCommon(dt, prevUploadBytes, txBytes, "tx_bytes");
     }
 
-    double GetNetworkBpsDownload(double dt)
+    double SampleNetworkBpsDownload(double dt)
     {
         // Better safe than sorry. Isn't 32bit max only a few GB?
         static uint64_t prevDownloadBytes = UINT64_MAX;
-        // Apparently /sys/class/net/.../statistics/[t/r]x_bytes is valid for all net devices under Linux
-        // https://www.kernel.org/doc/Documentation/ABI/testing/sysfs-class-net-statistics
-        return GetNetworkBpsCommon(dt, prevDownloadBytes, "/sys/class/net/" + Config::Get().networkAdapter + "/statistics/rx_bytes");
+        static SensorFile rxBytes;
+        return GetNetworkBpsCommon(dt, prevDownloadBytes, rxBytes, "rx_bytes");
     }
 
     void GetOutdatedPackagesAsync(std::function<void(uint32_t)>&& returnVal)
     {
         static bool currentlyRunning = false;
         static std::function<void(uint32_t)> handlerFunction;
-        static std::mutex configMutex;
 
+        if (!RuntimeConfig::Get().hasPackagesScript)
         {
-            std::scoped_lock<std::mutex> lock(configMutex);
-            if (!RuntimeConfig::Get().hasPackagesScript)
-            {
-                return; // Don't bother
-            }
-            handlerFunction = returnVal;
-            if (currentlyRunning)
-            {
-                // Thread is running, only update handler
-                return;
-            }
-
-            currentlyRunning = true;
+            return; // Don't bother
         }
-
-        std::thread(
-            [&]()
+        handlerFunction = std::move(returnVal);
+        if (currentlyRunning)
+        {
+            // Still running, only update handler
+            return;
+        }
+        currentlyRunning = true;
+
+        // We need a process, since there is no "libpacman". Syncing the package databases is background work, so keep it out of the way.
+        Process::Options options;
+        options.captureOutput = true;
+        options.nice = 10;
+        options.ioniceClass = 3;
+        Process::RunShell(
+            Config::Get().checkPackagesCommand,
+            [](const Process::Result& result)
             {
-                // We need a pipe, since there is no "libpacman". This should only be called every so often anyways
-                std::string number;
-                char buf[2056];
-                FILE* pipe = popen(Config::Get().checkPackagesCommand.c_str(), "r"); // Redirect stderr
-                ASSERT(pipe, "GetOutdatedPackages: Couldn't open pipe");
-                while (fgets(buf, sizeof(buf), pipe) != 0)
+                currentlyRunning = false;
+                if (result.exitCode != 0)
                 {
-                    number.append(buf);
+                    // Invalid script/error
+                    LOG("GetOutdatedPackages: Invalid command. Disabling package widget!");
+                    RuntimeConfig::Get().hasPackagesScript = false;
+                    return;
                 }
-
-                ASSERT(feof(pipe), "GetOutdatedPackages: Cannot read to eof!");
-
-                int exitCode = pclose(pipe) / 256;
+                try
+                {
+                    handlerFunction(std::stoul(result.output));
+                }
+                catch (std::logic_error&)
                 {
-                    std::scoped_lock<std::mutex> lock(configMutex);
-                    if (exitCode != 0)
-                    {
-                        // Invalid script/error
-                        LOG("GetOutdatedPackages: Invalid command. Disabling package widget!");
-                        RuntimeConfig::Get().hasPackagesScript = false;
-                        currentlyRunning = false;
-                        return;
-                    }
-                    try
-                    {
-                        handlerFunction(std::stoul(buf));
-                    }
-                    catch (std::invalid_argument&)
-                    {
-                        LOG("GetOutdatedPackages: Invalid output of the package script. Disabling package widget!");
-                        RuntimeConfig::Get().hasPackagesScript = false;
-                    }
-                    currentlyRunning = false;
+                    LOG("GetOutdatedPackages: Invalid output of the package script. Disabling package widget!");
+                    RuntimeConfig::Get().hasPackagesScript = false;
                 }
-            })
-            .detach();
+            },
+            std::move(options));
     }
 
     std::string GetTime()
@@ -660,45 +690,77 @@ namespace System
         return str.str();
     }
 
+    // Title, when there is no window to show. TODO Customize!!
+    constexpr const char* noWindowTitle = "No Active Window";
+
     std::string GetActiveWindowTitle()
     {
-        Wayland::PollEvents();
         const Wayland::Window* activeWindow = Wayland::GetActiveWindow();
         if (!activeWindow)
-            return "No Active Window"; // TODO Customize!!
+            return noWindowTitle;
 
         return activeWindow->title;
     }
 
+    std::string GetFocusedWindowTitle(const std::string& monitor)
+    {
+        const Wayland::Window* focusedWindow = Wayland::GetFocusedWindow(monitor);
+        if (!focusedWindow)
+        {
+            const Wayland::Window* activeWindow = Wayland::GetActiveWindow();
+            if (activeWindow && activeWindow->outputs.empty())
+            {
+                // The compositor doesn't tell us, on which output the window is
+                return activeWindow->title;
+            }
+            return noWindowTitle;
+        }
+        return focusedWindow->title;
+    }
+
+    uint32_t AddFocusedWindowChangeCallback(std::function<void()>&& callback)
+    {
+        return Wayland::AddChangeCallback(Wayland::Change::Focus, std::move(callback));
+    }
+
+    void RemoveFocusedWindowChangeCallback(uint32_t id)
+    {
+        Wayland::RemoveChangeCallback(id);
+    }
+
     void Shutdown()
     {
-        system("shutdown 0");
+        Process::Run({"shutdown", "0"});
     }
 
     void Reboot()
     {
-        system("reboot");
+        Process::Run({"reboot"});
     }
 
     void ExitWM()
     {
-        system(Config::Get().exitCommand.c_str());
+        Process::RunShell(Config::Get().exitCommand);
     }
 
     void Lock()
     {
-        system(Config::Get().lockCommand.c_str());
+        Process::RunShell(Config::Get().lockCommand);
     }
 
     void Suspend()
     {
-        system(Config::Get().suspendCommand.c_str());
+        Process::RunShell(Config::Get().suspendCommand);
     }
 
+    static std::string configLocation;
+
     void Init(const std::string& overrideConfigLocation)
     {
         Logging::Init();
+        MainQueue::Init();
 
+        configLocation = overrideConfigLocation;
         Config::Load(overrideConfigLocation);
 
         Wayland::Init();
@@ -726,13 +788,44 @@ namespace System
 #endif
 
         CheckNetwork();
+        CheckBattery();
+    }
+    void ReloadConfig()
+    {
+        // The sampler thread reads the config and the sensor files
+        Sampler::Shutdown();
+        Config::Load(configLocation);
+        // Reopened with the new paths on the next read
+        SensorFile::CloseAll();
+        RuntimeConfig::Get().hasNet = true;
+        RuntimeConfig::Get().hasBattery = true;
+        CheckNetwork();
+        CheckBattery();
     }
     void FreeResources()
     {
+        // Background work may still use the backends below
+        WorkerPool::Shutdown();
+        const WorkerPool::Counters& poolCounters = WorkerPool::GetCounters();
+        if (poolCounters.submitted)
+        {
+            uint64_t avgLatencyUS = poolCounters.executed ? poolCounters.totalLatencyUS / poolCounters.executed : 0;
+            LOG("WorkerPool: " << poolCounters.executed << " tasks (" << poolCounters.coalesced << " coalesced, " << poolCounters.dropped
+                               << " dropped), max queue depth " << poolCounters.maxQueueDepth << ", latency avg " << avgLatencyUS << "us, max "
+                               << poolCounters.maxLatencyUS << "us");
+        }
+
+        // Stop sampling before the sensor backends go away
+        Sampler::Shutdown();
+        const SensorFile::Counters& sensorFileCounters = SensorFile::GetCounters();
+        LOG("SensorFile: " << sensorFileCounters.opens << " opens (" << sensorFileCounters.reopens << " reopens, " << sensorFileCounters.failedOpens
+                           << " failed), " << sensorFileCounters.reads << " reads (" << sensorFileCounters.failedReads << " failed)");
+
 #ifdef WITH_NVIDIA
         NvidiaGPU::Shutdown();
 #endif
         PulseAudio::Shutdown();
+        PeakMeter::Shutdown();
 
 #ifdef WITH_WORKSPACES
         Workspaces::Shutdown();
@@ -740,10 +833,14 @@ namespace System
 
 #ifdef WITH_BLUEZ
         StopBTScan();
+        BlueZ::Shutdown();
 #endif
 #ifdef WITH_SNI
         SNI::Shutdown();
 #endif
+        Process::Shutdown();
+        // After everything, that posts from other threads
+        MainQueue::Shutdown();
 
         Wayland::Shutdown();
 
@@ -6,20 +6,39 @@
 
 namespace System
 {
-    // From 0-1, all cores
-    double GetCPUUsage();
-    // Tctl
-    double GetCPUTemp();
+    // All from 0-1 of the time since the last call, all cores
+    struct CPUInfo
+    {
+        // Everything, but idle
+        double usage;
+        double iowait;
+        // Hard and soft interrupts
+        double irq;
+        // Time stolen by the hypervisor
+        double steal;
+    };
 
-    bool IsBatteryCharging();
-    double GetBatteryPercentage();
+    // Indexed by the N of cpuN. Offline cores stay at 0.
+    struct CPUCoresInfo
+    {
+        // From 0-1 of the time since the last call
+        std::vector<float> usage;
+        std::vector<float> frequencyMHz;
+    };
+    // Number of configured (not necessarily online) cores
+    uint32_t GetCPUCoreCount();
 
     struct RAMInfo
     {
         double totalGiB;
+        // MemAvailable
         double freeGiB;
+        double buffersGiB;
+        // Page cache
+        double cachedGiB;
+        double swapTotalGiB;
+        double swapFreeGiB;
     };
-    RAMInfo GetRAMInfo();
 
 #if defined WITH_NVIDIA || defined WITH_AMD
     struct GPUInfo
@@ -27,14 +46,12 @@ namespace System
         double utilisation;
         double coreTemp;
     };
-    GPUInfo GetGPUInfo();
 
     struct VRAMInfo
     {
         double totalGiB;
         double usedGiB;
     };
-    VRAMInfo GetVRAMInfo();
 #endif
 
     struct DiskInfo
@@ -43,7 +60,75 @@ namespace System
         double totalGiB;
         double usedGiB;
     };
+
+    // Sensors, that are gathered by the background sampler
+    enum class Sensor
+    {
+        CPU,
+        CPUCores,
+        RAM,
+        GPU,
+        VRAM,
+        Disk,
+        Battery,
+        Network
+    };
+
+    struct SensorSnapshot
+    {
+        // Incremented with each sample. 0 means nothing has been sampled yet.
+        uint64_t sequence = 0;
+        // Bitmask of the sensors, that have been sampled into this snapshot
+        uint32_t sampledSensors = 0;
+
+        bool Has(Sensor sensor) const { return sampledSensors & (1 << (uint32_t)sensor); }
+
+        CPUInfo cpu{};
+        CPUCoresInfo cores{};
+        double cpuTemp = 0;
+        RAMInfo ram{};
+#if defined WITH_NVIDIA || defined WITH_AMD
+        GPUInfo gpu{};
+        VRAMInfo vram{};
+#endif
+        DiskInfo disk{};
+        double batteryPercentage = 0;
+        bool batteryCharging = false;
+        // Bytes per second
+        double networkUpBps = 0;
+        double networkDownBps = 0;
+    };
+
+    // The sensors are only available through the snapshot. The raw reads keep their previous sample and file buffers in statics,
+    // so they belong to the sampler thread alone (see Sampler.h).
+    // Adds the sensor to the set of sensors the sampler thread collects. Starts the sampler, if it isn't running already.
+    void EnableSensor(Sensor sensor);
+    // Returns the newest snapshot of the sampler. This never touches the filesystem.
+    // Only call this from the main thread!
+    const SensorSnapshot& GetSensorSnapshot();
+    // Samples all enabled sensors right away, instead of waiting for the next interval
+    void ResampleSensors();
+    // Called on the main thread, once the snapshot requested by ResampleSensors() is available
+    uint32_t AddSensorResampleCallback(std::function<void()>&& callback);
+    void RemoveSensorResampleCallback(uint32_t id);
+
+    // The getters from before the sampler, kept for plugins. They enable their sensor on the first call and return its value from the
+    // newest snapshot, so they never block but start out as 0. Only call them from the main thread!
+    // From 0-1, all cores
+    double GetCPUUsage();
+    // Tctl
+    double GetCPUTemp();
+    bool IsBatteryCharging();
+    double GetBatteryPercentage();
+    RAMInfo GetRAMInfo();
+#if defined WITH_NVIDIA || defined WITH_AMD
+    GPUInfo GetGPUInfo();
+    VRAMInfo GetVRAMInfo();
+#endif
     DiskInfo GetDiskInfo();
+    // Bytes per second. dt is unused, the sampler measures the time itself.
+    double GetNetworkBpsUpload(double dt);
+    double GetNetworkBpsDownload(double dt);
 
 #ifdef WITH_BLUEZ
     struct BluetoothDevice
@@ -54,6 +139,10 @@ namespace System
         std::string name;
         // Known types: input-[keyboard,mouse]; audio-headset
         std::string type;
+        // Signal strength in dBm, only known while discovering. 0, if unknown.
+        int16_t rssi;
+        // Battery percentage (org.bluez.Battery1). -1, if the device doesn't report it.
+        int32_t battery = -1;
     };
 
     struct BluetoothInfo
@@ -61,13 +150,20 @@ namespace System
         std::string defaultController;
         std::vector<BluetoothDevice> devices;
     };
-    BluetoothInfo GetBluetoothInfo();
+    // Cached, kept current by BlueZ signals
+    const BluetoothInfo& GetBluetoothInfo();
+    // Called on the main thread, after the adapters or devices changed.
+    // Changes of only the signal strength (RSSI) are reported, if rssiChanges is set.
+    uint32_t AddBluetoothChangeCallback(std::function<void()>&& callback, bool rssiChanges = false);
+    void RemoveBluetoothChangeCallback(uint32_t id);
     void StartBTScan();
     void StopBTScan();
 
-    // MT functions, callback, is from different thread
-    void ConnectBTDevice(BluetoothDevice& device, std::function<void(bool, BluetoothDevice&)> onFinish);
-    void DisconnectBTDevice(BluetoothDevice& device, std::function<void(bool, BluetoothDevice&)> onFinish);
+    // Asynchronous, onFinish is called later on the main thread. Returns an id for CancelBTRequest.
+    uint32_t ConnectBTDevice(const BluetoothDevice& device, std::function<void(bool success)>&& onFinish);
+    uint32_t DisconnectBTDevice(const BluetoothDevice& device, std::function<void(bool success)>&& onFinish);
+    // onFinish isn't called anymore
+    void CancelBTRequest(uint32_t id);
 
     void OpenBTWidget();
 
@@ -83,11 +179,55 @@ namespace System
         bool sourceMuted;
     };
     AudioInfo GetAudioInfo();
+    // Called on the main thread with the new info, whenever the volume or mute state of the default sink/source changed. Returns an id for
+    // removal.
+    uint32_t AddAudioChangeCallback(std::function<void(const AudioInfo&)>&& callback);
+    void RemoveAudioChangeCallback(uint32_t id);
     void SetVolumeSink(double volume);
     void SetVolumeSource(double volume);
     void SetMutedSink(bool muted);
     void SetMutedSource(bool muted);
 
+    enum class AudioStreamType
+    {
+        Sink,
+        Source,
+        // Playback stream of an application
+        SinkInput
+    };
+    struct AudioStream
+    {
+        AudioStreamType type;
+        // Only unique per type
+        uint32_t index;
+        // Internal name
+        std::string name;
+        std::string description;
+        double volume;
+        bool muted;
+        // Default sink/source
+        bool isDefault;
+    };
+    // Called on the main thread for each stream, that was added, changed or removed. Streams are only tracked while a callback is
+    // registered. The callback is called for every already known stream when registering. Returns an id for removal.
+    uint32_t AddAudioStreamCallback(std::function<void(const AudioStream& stream, bool removed)>&& callback);
+    void RemoveAudioStreamCallback(uint32_t id);
+    void SetAudioStreamVolume(AudioStreamType type, uint32_t index, double volume);
+    void SetAudioStreamMuted(AudioStreamType type, uint32_t index, bool muted);
+    // Only for sinks and sources
+    void SetDefaultAudioStream(AudioStreamType type, uint32_t index);
+
+    // Peak levels of what is currently played on the default sink and recorded by the default source. Each goes from 0-1
+    struct AudioLevel
+    {
+        double sink;
+        double source;
+    };
+    // Called on the main thread, whenever a level changed noticeably. Levels are only metered while a callback is registered. Returns an id
+    // for removal.
+    uint32_t AddAudioLevelCallback(std::function<void(const AudioLevel&)>&& callback);
+    void RemoveAudioLevelCallback(uint32_t id);
+
 #ifdef WITH_WORKSPACES
     enum class WorkspaceStatus
     {
@@ -100,23 +240,26 @@ namespace System
     void PollWorkspaces(const std::string& monitor, uint32_t numWorkspaces);
     WorkspaceStatus GetWorkspaceStatus(uint32_t workspace);
     uint32_t GetMaxUsedWorkspace();
+    // Called on the main thread, whenever the workspaces changed. Replaces the previous callback, nullptr removes it.
+    // Returns false, if the workspaces can't notify about changes and need to be polled instead.
+    bool SetWorkspaceChangeCallback(std::function<void()>&& callback);
     void GotoWorkspace(uint32_t workspace);
     // direction: + or -
     void GotoNextWorkspace(char direction);
     std::string GetWorkspaceSymbol(int index);
 #endif
 
-    // Bytes per second upload. dx is time since last call. Will always return 0 on first run
-    double GetNetworkBpsUpload(double dt);
-    // Bytes per second download. dx is time since last call. Will always return 0 on first run
-    double GetNetworkBpsDownload(double dt);
-
     // This can only be called one at a time. If it is already running it is assumed, that the old handler is no longer valid.
     void GetOutdatedPackagesAsync(std::function<void(uint32_t)>&& returnVal);
 
     std::string GetTime();
 
     std::string GetActiveWindowTitle();
+    // Title of the window, that was last focused on the monitor
+    std::string GetFocusedWindowTitle(const std::string& monitor);
+    // Called on the main thread, whenever the focused window of any monitor or its title changed. Returns an id for removal.
+    uint32_t AddFocusedWindowChangeCallback(std::function<void()>&& callback);
+    void RemoveFocusedWindowChangeCallback(uint32_t id);
 
     void Shutdown();
     void Reboot();
@@ -125,5 +268,7 @@ namespace System
     void Suspend();
 
     void Init(const std::string& overrideConfigLocation);
+    // Reads the config again. Stops the sampler, so the widgets have to be recreated afterwards to enable their sensors again.
+    void ReloadConfig();
     void FreeResources();
 }
@@ -4,6 +4,7 @@
 #include "Config.h"
 #include <wayland-client-protocol.h>
 #include <wayland-client.h>
+#include <glib.h>
 #include <ext-workspace-unstable-v1.h>
 #include <wlr-foreign-toplevel-management-unstable-v1.h>
 
@@ -20,11 +21,60 @@ namespace Wayland
     static zext_workspace_manager_v1* workspaceManager;
     static zwlr_foreign_toplevel_manager_v1* toplevelManager;
 
+    static uint32_t changes = 0;
+    struct ChangeCallback
+    {
+        uint32_t id;
+        Change change;
+        std::function<void()> callback;
+    };
+    static std::vector<ChangeCallback> changeCallbacks;
+    static uint32_t nextChangeCallbackId = 1;
+
+    static void MarkChanged(Change change)
+    {
+        changes |= BIT((uint32_t)change);
+    }
+
     static bool registeredMonitor = false;
     static bool registeredGroup = false;
     static bool registeredWorkspace = false;
     static bool registeredWorkspaceInfo = false;
 
+    // The currently activated toplevel, if any
+    static zwlr_foreign_toplevel_handle_v1* activeToplevel = nullptr;
+    // The last activated toplevel on each output
+    static std::unordered_map<wl_output*, zwlr_foreign_toplevel_handle_v1*> focusedOnOutput;
+    // The output of the last activated toplevel. Kept, when nothing is active anymore (e.g. the window was closed).
+    static wl_output* focusedOutput = nullptr;
+
+    static bool IsFocused(zwlr_foreign_toplevel_handle_v1* toplevel)
+    {
+        if (activeToplevel == toplevel)
+        {
+            return true;
+        }
+        // There are only a few outputs
+        for (auto& [output, focused] : focusedOnOutput)
+        {
+            if (focused == toplevel)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void SetFocusedOnOutput(wl_output* output, zwlr_foreign_toplevel_handle_v1* toplevel)
+    {
+        zwlr_foreign_toplevel_handle_v1*& focused = focusedOnOutput[output];
+        if (focused != toplevel)
+        {
+            focused = toplevel;
+            MarkChanged(Change::Focus);
+        }
+    }
+
     // Wayland callbacks
 
     // Workspace Callbacks
@@ -35,6 +85,7 @@ namespace Wayland
             workspaces[workspace].id = std::stoul(name);
             LOG("Workspace ID: " << workspaces[workspace].id);
             registeredWorkspaceInfo = true;
+            MarkChanged(Change::Workspaces);
         }
         catch (const std::invalid_argument&)
         {
@@ -64,6 +115,7 @@ namespace Wayland
         {
             LOG("Wayland: Deactivate Workspace " << workspace.id);
         }
+        MarkChanged(Change::Workspaces);
     }
     static void OnWorkspaceRemove(void*, zext_workspace_handle_v1* ws)
     {
@@ -83,6 +135,7 @@ namespace Wayland
             else
                 group.lastActiveWorkspace = nullptr;
         }
+        MarkChanged(Change::Workspaces);
     }
     zext_workspace_handle_v1_listener workspaceListener = {OnWorkspaceName, OnWorkspaceGeometry, OnWorkspaceState, OnWorkspaceRemove};
 
@@ -93,6 +146,7 @@ namespace Wayland
         ASSERT(monitor != monitors.end(), "Wayland: Registered WS group before monitor!");
         LOG("Wayland: Added group to monitor");
         monitor->second.workspaceGroup = group;
+        MarkChanged(Change::Workspaces);
     }
     static void OnWSGroupOutputLeave(void*, zext_workspace_group_handle_v1*, wl_output* output)
     {
@@ -100,6 +154,7 @@ namespace Wayland
         ASSERT(monitor != monitors.end(), "Wayland: Registered WS group before monitor!");
         LOG("Wayland: Added group to monitor");
         monitor->second.workspaceGroup = nullptr;
+        MarkChanged(Change::Workspaces);
     }
     static void OnWSGroupWorkspaceAdded(void*, zext_workspace_group_handle_v1* workspace, zext_workspace_handle_v1* ws)
     {
@@ -108,10 +163,12 @@ namespace Wayland
         workspaces[ws] = {workspace, (uint32_t)-1, false};
         zext_workspace_handle_v1_add_listener(ws, &workspaceListener, nullptr);
         registeredWorkspace = true;
+        MarkChanged(Change::Workspaces);
     }
     static void OnWSGroupRemove(void*, zext_workspace_group_handle_v1* workspaceGroup)
     {
         workspaceGroups.erase(workspaceGroup);
+        MarkChanged(Change::Workspaces);
     }
     zext_workspace_group_handle_v1_listener workspaceGroupListener = {OnWSGroupOutputEnter, OnWSGroupOutputLeave, OnWSGroupWorkspaceAdded,
                                                                       OnWSGroupRemove};
@@ -137,9 +194,37 @@ namespace Wayland
         auto window = windows.find(toplevel);
         ASSERT(window != windows.end(), "Wayland: OnTLTile called on unknwon toplevel!");
         window->second.title = title;
+        MarkChanged(Change::Toplevels);
+        if (IsFocused(toplevel))
+        {
+            MarkChanged(Change::Focus);
+        }
+    }
+    static void OnTLOutputEnter(void*, zwlr_foreign_toplevel_handle_v1* toplevel, wl_output* output)
+    {
+        auto window = windows.find(toplevel);
+        ASSERT(window != windows.end(), "Wayland: OnTLOutputEnter called on unknwon toplevel!");
+        window->second.outputs.push_back(output);
+        if (window->second.activated)
+        {
+            // Moved the focused window to another output
+            SetFocusedOnOutput(output, toplevel);
+            focusedOutput = output;
+        }
+    }
+    static void OnTLOutputLeave(void*, zwlr_foreign_toplevel_handle_v1* toplevel, wl_output* output)
+    {
+        auto window = windows.find(toplevel);
+        ASSERT(window != windows.end(), "Wayland: OnTLOutputLeave called on unknwon toplevel!");
+        auto& outputs = window->second.outputs;
+        outputs.erase(std::remove(outputs.begin(), outputs.end(), output), outputs.end());
+        auto focused = focusedOnOutput.find(output);
+        if (focused != focusedOnOutput.end() && focused->second == toplevel)
+        {
+            focusedOnOutput.erase(focused);
+            MarkChanged(Change::Focus);
+        }
     }
-    static void OnTLOutputEnter(void*, UNUSED zwlr_foreign_toplevel_handle_v1* toplevel, UNUSED wl_output* output) {}
-    static void OnTLOutputLeave(void*, UNUSED zwlr_foreign_toplevel_handle_v1* toplevel, UNUSED wl_output* output) {}
     static void OnTLState(void*, zwlr_foreign_toplevel_handle_v1* toplevel, wl_array* state)
     {
         auto window = windows.find(toplevel);
@@ -156,13 +241,47 @@ namespace Wayland
             }
         }
         window->second.activated = activated;
+        MarkChanged(Change::Toplevels);
+
+        if (activated && activeToplevel != toplevel)
+        {
+            activeToplevel = toplevel;
+            for (wl_output* output : window->second.outputs)
+            {
+                SetFocusedOnOutput(output, toplevel);
+            }
+            if (!window->second.outputs.empty())
+            {
+                focusedOutput = window->second.outputs.front();
+            }
+            MarkChanged(Change::Focus);
+        }
+        else if (!activated && activeToplevel == toplevel)
+        {
+            // Keep it as the last focused window of its outputs, but nothing is active anymore
+            activeToplevel = nullptr;
+            MarkChanged(Change::Focus);
+        }
     }
     static void OnTLAppID(void*, zwlr_foreign_toplevel_handle_v1* toplevel, const char* appId) {}
     static void OnTLDone(void*, zwlr_foreign_toplevel_handle_v1*) {}
     static void OnTLClosed(void*, zwlr_foreign_toplevel_handle_v1* toplevel)
     {
+        if (IsFocused(toplevel))
+        {
+            MarkChanged(Change::Focus);
+        }
+        if (activeToplevel == toplevel)
+        {
+            activeToplevel = nullptr;
+        }
+        for (auto it = focusedOnOutput.begin(); it != focusedOnOutput.end();)
+        {
+            it = it->second == toplevel ? focusedOnOutput.erase(it) : std::next(it);
+        }
         windows.erase(toplevel);
         zwlr_foreign_toplevel_handle_v1_destroy(toplevel);
+        MarkChanged(Change::Toplevels);
     }
     static void OnTLParent(void*, zwlr_foreign_toplevel_handle_v1*, zwlr_foreign_toplevel_handle_v1*) {}
     zwlr_foreign_toplevel_handle_v1_listener toplevelListener = {OnTLTitle, OnTLAppID, OnTLOutputEnter, OnTLOutputLeave,
@@ -219,6 +338,7 @@ namespace Wayland
         it->second.name = name;
         LOG("Wayland: Monitor at ID " << it->second.ID << " got name " << name);
         registeredMonitor = true;
+        MarkChanged(Change::Monitors);
     }
     static void OnOutputDescription(void*, wl_output*, const char*) {}
     wl_output_listener outputListener = {OnOutputGeometry, OnOutputMode, OnOutputDone, OnOutputScale, OnOutputName, OnOutputDescription};
@@ -268,15 +388,115 @@ namespace Wayland
                 }
             }
             registeredMonitor = true;
+            focusedOnOutput.erase(it->first);
+            if (focusedOutput == it->first)
+            {
+                focusedOutput = nullptr;
+            }
             monitors.erase(it);
+            MarkChanged(Change::Monitors);
         }
     }
 
     wl_registry_listener registryListener = {OnRegistryAdd, OnRegistryRemove};
 
+    static void NotifyChanges()
+    {
+        uint32_t curChanges = changes;
+        changes = 0;
+        // Callbacks may remove themselves, so don't hold on to iterators
+        for (size_t i = 0; i < changeCallbacks.size(); i++)
+        {
+            if (curChanges & BIT((uint32_t)changeCallbacks[i].change))
+            {
+                // Copy, since the callback may remove itself
+                std::function<void()> callback = changeCallbacks[i].callback;
+                callback();
+            }
+        }
+    }
+
+    // GSource, that reads and dispatches the events of the display as soon as they arrive.
+    struct DisplaySource
+    {
+        GSource source;
+        gpointer fdTag;
+        // Whether we announced our intention to read (wl_display_prepare_read) and haven't read or cancelled yet
+        bool reading;
+    };
+    static DisplaySource* displaySource;
+
+    static gboolean DisplaySourcePrepare(GSource* source, gint* timeout)
+    {
+        DisplaySource* src = (DisplaySource*)source;
+        *timeout = -1;
+        if (!src->reading)
+        {
+            if (wl_display_prepare_read(display) != 0)
+            {
+                // There are already events in the queue, dispatch them right away
+                return true;
+            }
+            src->reading = true;
+        }
+        // Send our requests, before we go to sleep
+        wl_display_flush(display);
+        return false;
+    }
+
+    static gboolean DisplaySourceCheck(GSource* source)
+    {
+        DisplaySource* src = (DisplaySource*)source;
+        if (!src->reading)
+        {
+            return false;
+        }
+        src->reading = false;
+        GIOCondition revents = g_source_query_unix_fd(source, src->fdTag);
+        if (revents & G_IO_IN)
+        {
+            // Errors are reported by wl_display_dispatch_pending in dispatch
+            wl_display_read_events(display);
+            return true;
+        }
+        wl_display_cancel_read(display);
+        // Hang ups are handled in dispatch
+        return revents & (G_IO_HUP | G_IO_ERR);
+    }
+
+    static gboolean DisplaySourceDispatch(GSource* source, GSourceFunc, gpointer)
+    {
+        DisplaySource* src = (DisplaySource*)source;
+        if (g_source_query_unix_fd(source, src->fdTag) & (G_IO_HUP | G_IO_ERR) || wl_display_dispatch_pending(display) < 0)
+        {
+            LOG("Wayland: Lost connection to the compositor!");
+            displaySource = nullptr;
+            return G_SOURCE_REMOVE;
+        }
+        NotifyChanges();
+        return G_SOURCE_CONTINUE;
+    }
+
+    static GSourceFuncs displaySourceFuncs = {DisplaySourcePrepare, DisplaySourceCheck, DisplaySourceDispatch, nullptr, nullptr, nullptr};
+
+    static void AttachDisplaySource()
+    {
+        displaySource = (DisplaySource*)g_source_new(&displaySourceFuncs, sizeof(DisplaySource));
+        displaySource->reading = false;
+        displaySource->fdTag = g_source_add_unix_fd(&displaySource->source, wl_display_get_fd(display), (GIOCondition)(G_IO_IN | G_IO_HUP | G_IO_ERR));
+        g_source_attach(&displaySource->source, nullptr);
+        g_source_unref(&displaySource->source);
+    }
+
     // Dispatch events.
     static void Dispatch()
     {
+        if (displaySource && displaySource->reading)
+        {
+            // A pending read intent would block the roundtrip forever
+            wl_display_cancel_read(display);
+            displaySource->reading = false;
+        }
         wl_display_roundtrip(display);
     }
     static void WaitFor(bool& condition)
@@ -299,6 +519,9 @@ namespace Wayland
         WaitFor(registeredMonitor);
         registeredMonitor = false;
 
+        // From now on, events are handled by the main loop
+        AttachDisplaySource();
+
         if (!workspaceManager && !Config::Get().useHyprlandIPC)
         {
             LOG("Compositor doesn't implement zext_workspace_manager_v1, disabling workspaces!");
@@ -350,10 +573,35 @@ namespace Wayland
         registeredGroup = false;
         registeredWorkspace = false;
         registeredWorkspaceInfo = false;
+        NotifyChanges();
+    }
+
+    uint32_t AddChangeCallback(Change change, std::function<void()>&& callback)
+    {
+        uint32_t id = nextChangeCallbackId++;
+        changeCallbacks.push_back({id, change, std::move(callback)});
+        return id;
+    }
+
+    void RemoveChangeCallback(uint32_t id)
+    {
+        changeCallbacks.erase(std::remove_if(changeCallbacks.begin(), changeCallbacks.end(),
+                                             [&](const ChangeCallback& callback)
+                                             {
+                                                 return callback.id == id;
+                                             }),
+                              changeCallbacks.end());
     }
 
     void Shutdown()
     {
+        if (displaySource)
+        {
+            if (displaySource->reading)
+                wl_display_cancel_read(display);
+            g_source_destroy(&displaySource->source);
+            displaySource = nullptr;
+        }
         if (display)
             wl_display_disconnect(display);
     }
@@ -386,14 +634,32 @@ namespace Wayland
 
     const Window* GetActiveWindow()
     {
-        auto it = std::find_if(windows.begin(), windows.end(),
-                               [&](const std::pair<zwlr_foreign_toplevel_handle_v1*, Window>& el)
-                               {
-                                   return el.second.activated == true;
-                               });
-        if (it == windows.end())
+        if (!activeToplevel)
+            return nullptr;
+        return &windows.at(activeToplevel);
+    }
+
+    const Window* GetFocusedWindow(const std::string& monitorName)
+    {
+        auto monitor = std::find_if(monitors.begin(), monitors.end(),
+                                    [&](const std::pair<wl_output*, Monitor>& el)
+                                    {
+                                        return el.second.name == monitorName;
+                                    });
+        if (monitor == monitors.end())
+            return nullptr;
+        auto focused = focusedOnOutput.find(monitor->first);
+        if (focused == focusedOnOutput.end())
             return nullptr;
-        return &it->second;
+        return &windows.at(focused->second);
+    }
+
+    std::string GetFocusedMonitor()
+    {
+        auto monitor = monitors.find(focusedOutput);
+        if (monitor == monitors.end())
+            return "";
+        return monitor->second.name;
     }
 
     const std::unordered_map<wl_output*, Monitor>& GetMonitors()
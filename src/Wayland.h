@@ -1,6 +1,8 @@
 #pragma once
 #include "Common.h"
 
+#include <functional>
+
 struct wl_output;
 struct zext_workspace_group_handle_v1;
 struct zext_workspace_handle_v1;
@@ -35,11 +37,29 @@ namespace Wayland
     {
         std::string title;
         bool activated;
+        // The outputs the window is visible on
+        std::vector<wl_output*> outputs;
+    };
+
+    // What changed in a batch of events
+    enum class Change
+    {
+        Monitors,
+        Workspaces,
+        Toplevels,
+        // The active window, the last focused window of an output or the title of one of them
+        Focus,
+        Count
     };
 
     void Init();
+    // Events are dispatched by the main loop as they arrive. This forces a roundtrip, for when the state needs to be up to date right now.
     void PollEvents();
 
+    // callback is called on the main thread after a batch of events, that changed something. Returns an id for RemoveChangeCallback.
+    uint32_t AddChangeCallback(Change change, std::function<void()>&& callback);
+    void RemoveChangeCallback(uint32_t id);
+
     const std::unordered_map<wl_output*, Monitor>& GetMonitors();
     const std::unordered_map<zext_workspace_group_handle_v1*, WorkspaceGroup>& GetWorkspaceGroups();
     const std::unordered_map<zext_workspace_handle_v1*, Workspace>& GetWorkspaces();
@@ -70,6 +90,10 @@ namespace Wayland
     }
 
     const Window* GetActiveWindow();
+    // The window, that was last focused on the monitor. It doesn't have to be active.
+    const Window* GetFocusedWindow(const std::string& monitorName);
+    // The monitor of the active window, or of the last one, if no window is active. Empty, if no window was activated yet.
+    std::string GetFocusedMonitor();
 
     void Shutdown();
 }
@@ -2,6 +2,7 @@
 #include "Common.h"
 #include "CSS.h"
 
+#include <algorithm>
 #include <cmath>
 
 // TODO: Currently setters only work pre-create. Make them react to changes after creation!
@@ -47,6 +48,10 @@ namespace Utils
 
 Widget::~Widget()
 {
+    for (auto& onDestroy : m_OnDestroy)
+    {
+        onDestroy();
+    }
     if (m_Widget)
     {
         // LOG("Destroy widget and its children");
@@ -387,6 +392,106 @@ void Sensor::Draw(cairo_t* cr)
     gdk_rgba_free(fgCol);
 }
 
+void SensorStrip::SetValues(const std::vector<float>& values)
+{
+    if (values != m_Values)
+    {
+        m_Values = values;
+        if (m_Widget)
+        {
+            gtk_widget_queue_draw(m_Widget);
+        }
+    }
+}
+
+void SensorStrip::Draw(cairo_t* cr)
+{
+    if (m_Values.empty())
+        return;
+
+    GtkAllocation dim;
+    gtk_widget_get_allocation(m_Widget, &dim);
+    bool horizontal = m_Orientation == Orientation::Horizontal;
+    // Size of a single bar along and across the strip
+    double barSize = (double)(horizontal ? dim.width : dim.height) / m_Values.size();
+    double barLength = horizontal ? dim.height : dim.width;
+
+    auto style = gtk_widget_get_style_context(m_Widget);
+    GdkRGBA* bgCol;
+    GdkRGBA* fgCol;
+    gtk_style_context_get(style, GTK_STATE_FLAG_NORMAL, GTK_STYLE_PROPERTY_BACKGROUND_COLOR, &bgCol, NULL);
+    gtk_style_context_get(style, GTK_STATE_FLAG_NORMAL, GTK_STYLE_PROPERTY_COLOR, &fgCol, NULL);
+
+    // Background
+    cairo_set_source_rgb(cr, bgCol->red, bgCol->green, bgCol->blue);
+    cairo_rectangle(cr, 0, 0, dim.width, dim.height);
+    cairo_fill(cr);
+
+    // All bars as one path, so they are filled at once.
+    // Horizontal strips fill from the bottom, vertical ones from the left.
+    for (size_t i = 0; i < m_Values.size(); i++)
+    {
+        double fill = std::clamp((double)m_Values[i], 0., 1.) * barLength;
+        if (horizontal)
+        {
+            cairo_rectangle(cr, i * barSize, barLength - fill, barSize, fill);
+        }
+        else
+        {
+            cairo_rectangle(cr, 0, i * barSize, fill, barSize);
+        }
+    }
+    cairo_set_source_rgb(cr, fgCol->red, fgCol->green, fgCol->blue);
+    cairo_fill(cr);
+
+    gdk_rgba_free(bgCol);
+    gdk_rgba_free(fgCol);
+}
+
+void LevelMeter::SetLevel(double level)
+{
+    if (level != m_Level)
+    {
+        m_Level = level;
+        if (m_Widget)
+        {
+            gtk_widget_queue_draw(m_Widget);
+        }
+    }
+}
+
+void LevelMeter::Draw(cairo_t* cr)
+{
+    GtkAllocation dim;
+    gtk_widget_get_allocation(m_Widget, &dim);
+
+    auto style = gtk_widget_get_style_context(m_Widget);
+    GdkRGBA* bgCol;
+    GdkRGBA* fgCol;
+    gtk_style_context_get(style, GTK_STATE_FLAG_NORMAL, GTK_STYLE_PROPERTY_BACKGROUND_COLOR, &bgCol, NULL);
+    gtk_style_context_get(style, GTK_STATE_FLAG_NORMAL, GTK_STYLE_PROPERTY_COLOR, &fgCol, NULL);
+
+    cairo_set_source_rgb(cr, bgCol->red, bgCol->green, bgCol->blue);
+    cairo_rectangle(cr, 0, 0, dim.width, dim.height);
+    cairo_fill(cr);
+
+    // Horizontal meters grow to the right, vertical ones upwards
+    double level = std::clamp(m_Level, 0., 1.);
+    if (m_Orientation == Orientation::Horizontal)
+    {
+        cairo_rectangle(cr, 0, 0, level * dim.width, dim.height);
+    }
+    else
+    {
+        cairo_rectangle(cr, 0, dim.height * (1 - level), dim.width, dim.height * level);
+    }
+    cairo_set_source_rgb(cr, fgCol->red, fgCol->green, fgCol->blue);
+    cairo_fill(cr);
+
+    gdk_rgba_free(bgCol);
+    gdk_rgba_free(fgCol);
+}
+
 static std::string NetworkSensorPercentToCSS(double percent)
 {
     if (percent <= 0.)
@@ -586,6 +691,15 @@ void Texture::Draw(cairo_t* cr)
     cairo_fill(cr);
 }
 
+void ScrollingArea::Create()
+{
+    m_Widget = gtk_scrolled_window_new(nullptr, nullptr);
+    gtk_scrolled_window_set_policy((GtkScrolledWindow*)m_Widget, GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+    gtk_scrolled_window_set_propagate_natural_height((GtkScrolledWindow*)m_Widget, true);
+    gtk_scrolled_window_set_max_content_height((GtkScrolledWindow*)m_Widget, m_MaxHeight);
+    ApplyPropertiesToWidget();
+}
+
 void Revealer::SetTransition(Transition transition)
 {
     m_Transition = transition;
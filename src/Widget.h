@@ -169,6 +169,8 @@ public:
     void SetVisible(bool visible);
 
     void SetOnCreate(Callback<Widget>&& onCreate) { m_OnCreate = onCreate; }
+    // Called, when the widget is destroyed. Use this to unregister callbacks, that reference the widget.
+    void AddOnDestroy(std::function<void()>&& onDestroy) { m_OnDestroy.push_back(std::move(onDestroy)); }
 
 protected:
     void PropagateToParent(GdkEvent* event);
@@ -185,6 +187,7 @@ protected:
     Transform m_VerticalTransform;   // Y
 
     Callback<Widget> m_OnCreate;
+    std::vector<std::function<void()>> m_OnDestroy;
 
     std::unordered_set<guint> m_Timeouts;
 };
@@ -252,10 +255,42 @@ public:
 private:
     void Draw(cairo_t* cr) override;
 
-    double m_Val;
+    double m_Val = 0;
     SensorStyle m_Style{};
 };
 
+// Draws many values as a strip of bars in a single draw call. Used e.g. for per core usage.
+class SensorStrip : public CairoArea
+{
+public:
+    // Each value goes from 0-1
+    void SetValues(const std::vector<float>& values);
+    // Direction, in which the bars are laid out
+    void SetOrientation(Orientation orientation) { m_Orientation = orientation; }
+
+private:
+    void Draw(cairo_t* cr) override;
+
+    std::vector<float> m_Values;
+    Orientation m_Orientation = Orientation::Horizontal;
+};
+
+// A single bar for audio levels. Only redraws, when the level changed.
+class LevelMeter : public CairoArea
+{
+public:
+    // Goes from 0-1
+    void SetLevel(double level);
+    // Direction, in which the bar grows
+    void SetOrientation(Orientation orientation) { m_Orientation = orientation; }
+
+private:
+    void Draw(cairo_t* cr) override;
+
+    double m_Level = 0;
+    Orientation m_Orientation = Orientation::Horizontal;
+};
+
 class NetworkSensor : public CairoArea
 {
 public:
@@ -310,6 +345,18 @@ private:
     GdkPixbuf* m_Pixbuf;
 };
 
+// Scrolls its child vertically, once it gets taller than the max height. Until then it is as tall as the child.
+class ScrollingArea : public Widget
+{
+public:
+    void SetMaxHeight(int32_t maxHeight) { m_MaxHeight = maxHeight; }
+
+    virtual void Create() override;
+
+private:
+    int32_t m_MaxHeight = -1;
+};
+
 class Revealer : public Widget
 {
 public:
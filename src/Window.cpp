@@ -11,6 +11,12 @@ Window::Window(const std::string& monitor) : m_MonitorName(monitor) {}
 
 Window::~Window()
 {
+    // The idle references this window
+    if (m_CloseSource)
+    {
+        g_source_remove(m_CloseSource);
+        m_CloseSource = 0;
+    }
     if (m_App)
     {
         g_object_unref(m_App);
@@ -123,6 +129,21 @@ void Window::Run()
     }
 }
 
+void Window::Open()
+{
+    bOpened = true;
+    m_TargetMonitor = m_MonitorName;
+    GdkDisplay* display = gdk_display_get_default();
+    int32_t monitorID = m_MonitorName.empty() ? -1 : Wayland::NameToGtkMonitorID(m_MonitorName);
+    m_Monitor = monitorID != -1 ? gdk_display_get_monitor(display, monitorID) : nullptr;
+    if (!m_Monitor)
+    {
+        LOG("Window: Requested monitor not found. Falling back to current monitor!")
+        m_Monitor = gdk_display_get_primary_monitor(display);
+    }
+    Create();
+}
+
 void Window::Create()
 {
     LOG("Window: Create on monitor " << m_MonitorName);
@@ -173,15 +194,52 @@ void Window::Create()
 
 void Window::Destroy()
 {
+    if (m_CloseSource)
+    {
+        g_source_remove(m_CloseSource);
+        m_CloseSource = 0;
+    }
+    if (!m_Window)
+        return;
     LOG("Window: Destroy");
     m_MainWidget = nullptr;
     gtk_widget_destroy((GtkWidget*)m_Window);
+    m_Window = nullptr;
 }
 
-void Window::Close()
+void Window::Recreate()
 {
+    if (!m_MainWidget)
+        return;
     Destroy();
-    bShouldQuit = true;
+    Create();
+}
+
+void Window::Close()
+{
+    if (!bOpened)
+    {
+        Destroy();
+        bShouldQuit = true;
+        return;
+    }
+    if (m_CloseSource)
+        return;
+    // Mostly called from callbacks of our own widgets, so destroy them after those returned
+    m_CloseSource = g_idle_add(
+        +[](void* data) -> int
+        {
+            Window* window = (Window*)data;
+            // Removed by returning false
+            window->m_CloseSource = 0;
+            window->Destroy();
+            // Copy, since the callback may delete the window
+            std::function<void()> onClose = window->OnClose;
+            if (onClose)
+                onClose();
+            return false;
+        },
+        this);
 }
 
 void Window::UpdateMargin()
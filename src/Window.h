@@ -31,7 +31,18 @@ public:
     void Init(const std::string& overrideConfigLocation);
     void Run();
 
+    // Shows the window on the already running main loop of another window (e.g. popups of the bar), instead of Init() + Run().
+    // GTK, CSS and the System backends are expected to be initialized already.
+    void Open();
+
+    // Quits Run(). Opened windows are only destroyed and OnClose is called (which may delete the window).
     void Close();
+    // Destroys the GTK window and the widgets right away. Cancels a queued Close(), so OnClose isn't called. Does nothing, if the window
+    // is already destroyed.
+    void Destroy();
+
+    // Destroys and creates the main widget again through OnWidget, e.g. after the config changed
+    void Recreate();
 
     void SetAnchor(Anchor anchor) { m_Anchor = anchor; }
     void SetMargin(Anchor anchor, int32_t margin);
@@ -49,10 +60,11 @@ public:
 
     // Callback when the widget should be recreated
     std::function<void()> OnWidget;
+    // Callback after an opened window was closed
+    std::function<void()> OnClose;
 
 private:
     void Create();
-    void Destroy();
 
     void UpdateMargin();
 
@@ -82,4 +94,7 @@ private:
 
     bool bShouldQuit = false;
     bool bHandleMonitorChanges = false;
+    bool bOpened = false;
+    // Idle source of a queued Close()
+    guint m_CloseSource = 0;
 };
@@ -0,0 +1,181 @@
+#include "WorkerPool.h"
+#include "Common.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace WorkerPool
+{
+    // Nothing submitted here is CPU bound, it's all waiting on files, sockets or processes
+    constexpr size_t numWorkers = 2;
+    constexpr size_t maxQueueSize = 64;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry
+    {
+        // 0 = Not coalesced
+        uintptr_t key;
+        Task task;
+        Clock::time_point submitTime;
+    };
+
+    static std::mutex queueMutex;
+    static std::condition_variable queueWakeup;
+    // Small enough, that searching it for a key is cheaper than keeping an index up to date
+    static std::deque<Entry> queue;
+    static std::unordered_set<uintptr_t> runningKeys;
+    static std::vector<std::thread> workers;
+    static bool running = false;
+    static bool shutDown = false;
+
+    static Counters counters;
+
+    static void UpdateMax(std::atomic<uint64_t>& max, uint64_t value)
+    {
+        uint64_t prev = max;
+        while (prev < value && !max.compare_exchange_weak(prev, value))
+        {
+        }
+    }
+
+    // Needs the queue lock. Returns the first task, whose key isn't already running.
+    static std::deque<Entry>::iterator FindRunnable()
+    {
+        return std::find_if(queue.begin(), queue.end(),
+                            [](const Entry& entry)
+                            {
+                                return entry.key == 0 || runningKeys.count(entry.key) == 0;
+                            });
+    }
+
+    static void Run()
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        while (true)
+        {
+            auto it = queue.end();
+            queueWakeup.wait(lock,
+                             [&]()
+                             {
+                                 it = FindRunnable();
+                                 return !running || it != queue.end();
+                             });
+            if (!running)
+                break;
+
+            Entry entry = std::move(*it);
+            queue.erase(it);
+            counters.queueDepth = queue.size();
+            if (entry.key)
+                runningKeys.insert(entry.key);
+            lock.unlock();
+
+            uint64_t latencyUS = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - entry.submitTime).count();
+            counters.totalLatencyUS += latencyUS;
+            UpdateMax(counters.maxLatencyUS, latencyUS);
+
+            entry.task();
+            counters.executed++;
+            // Don't destroy the captures with the lock held
+            entry.task = nullptr;
+
+            lock.lock();
+            if (entry.key)
+            {
+                runningKeys.erase(entry.key);
+                // A task with the same key may have waited for this one
+                queueWakeup.notify_one();
+            }
+        }
+    }
+
+    static bool Enqueue(uintptr_t key, Task&& task)
+    {
+        counters.submitted++;
+        std::scoped_lock<std::mutex> lock(queueMutex);
+        if (shutDown)
+        {
+            counters.dropped++;
+            return false;
+        }
+
+        if (key)
+        {
+            auto queued = std::find_if(queue.begin(), queue.end(),
+                                       [key](const Entry& entry)
+                                       {
+                                           return entry.key == key;
+                                       });
+            if (queued != queue.end())
+            {
+                // Keep the position and submit time, so a stream of updates can't starve the key
+                queued->task = std::move(task);
+                counters.coalesced++;
+                return true;
+            }
+        }
+
+        if (queue.size() >= maxQueueSize)
+        {
+            counters.dropped++;
+            return false;
+        }
+        queue.push_back(Entry{key, std::move(task), Clock::now()});
+        counters.queueDepth = queue.size();
+        if (counters.queueDepth > counters.maxQueueDepth)
+            counters.maxQueueDepth = counters.queueDepth.load();
+
+        if (!running)
+        {
+            LOG("WorkerPool: Starting " << numWorkers << " workers");
+            running = true;
+            for (size_t i = 0; i < numWorkers; i++)
+            {
+                workers.emplace_back(Run);
+            }
+        }
+        queueWakeup.notify_one();
+        return true;
+    }
+
+    bool Submit(Task&& task)
+    {
+        return Enqueue(0, std::move(task));
+    }
+
+    bool Submit(uintptr_t key, Task&& task)
+    {
+        ASSERT(key != 0, "WorkerPool: Key 0 is reserved");
+        return Enqueue(key, std::move(task));
+    }
+
+    const Counters& GetCounters()
+    {
+        return counters;
+    }
+
+    void Shutdown()
+    {
+        std::deque<Entry> dropped;
+        {
+            std::scoped_lock<std::mutex> lock(queueMutex);
+            shutDown = true;
+            running = false;
+            counters.dropped += queue.size();
+            dropped.swap(queue);
+            counters.queueDepth = 0;
+        }
+        queueWakeup.notify_all();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+        workers.clear();
+    }
+}
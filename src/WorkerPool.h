@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+// A few worker threads for blocking work, that shouldn't run on the main thread. The queue is bounded, so bursts of requests (e.g. dragging
+// a slider) can't create threads or memory without bound. Tasks must not touch GTK.
+namespace WorkerPool
+{
+    using Task = std::function<void()>;
+
+    struct Counters
+    {
+        std::atomic<uint64_t> submitted = 0;
+        // Replaced by a newer task with the same key, before they started
+        std::atomic<uint64_t> coalesced = 0;
+        // Rejected, because the queue was full or the pool shut down
+        std::atomic<uint64_t> dropped = 0;
+        std::atomic<uint64_t> executed = 0;
+        std::atomic<uint32_t> queueDepth = 0;
+        std::atomic<uint32_t> maxQueueDepth = 0;
+        // Time from submitting to starting the task
+        std::atomic<uint64_t> totalLatencyUS = 0;
+        std::atomic<uint64_t> maxLatencyUS = 0;
+    };
+
+    // Returns false, if the task was dropped
+    bool Submit(Task&& task);
+    // Latest wins: A queued task with the same key is replaced. Tasks with the same key never run concurrently, so a key can
+    // be used like a "one at a time" lock. The key must not be 0.
+    bool Submit(uintptr_t key, Task&& task);
+
+    const Counters& GetCounters();
+
+    // Drops the queued tasks and waits for the running ones
+    void Shutdown();
+}
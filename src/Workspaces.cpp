@@ -1,8 +1,17 @@
 #include "Workspaces.h"
 #include "Wayland.h"
+#include "HyprlandReply.h"
+#include "Process.h"
+#include "MainQueue.h"
 #include <ext-workspace-unstable-v1.h>
+#include <array>
+#include <charconv>
+#include <cstring>
 #include <unordered_map>
 
+#include <fcntl.h>
+#include <glib-unix.h>
+
 #ifdef WITH_WORKSPACES
 namespace Workspaces
 {
@@ -15,9 +24,26 @@ namespace Workspaces
         static std::string lastPolledMonitor;
         void PollStatus(const std::string& monitor, uint32_t)
         {
-            ::Wayland::PollEvents();
+            // Events are handled by the main loop, so the state is always up to date
             lastPolledMonitor = monitor;
         }
+        static std::function<void()> onChange;
+        bool SetOnChange(std::function<void()>&& callback)
+        {
+            static bool registered = false;
+            if (!registered)
+            {
+                ::Wayland::AddChangeCallback(::Wayland::Change::Workspaces,
+                                             []()
+                                             {
+                                                 if (onChange)
+                                                     onChange();
+                                             });
+                registered = true;
+            }
+            onChange = std::move(callback);
+            return true;
+        }
         System::WorkspaceStatus GetStatus(uint32_t workspaceId)
         {
             const ::Wayland::Monitor* monitor = ::Wayland::FindMonitorByName(lastPolledMonitor);
@@ -92,7 +118,7 @@ namespace Workspaces
             }
         }
 
-        std::string GetSocketPath()
+        std::string GetSocketPath(const char* socketName)
         {
             const char* instanceSignature = getenv("HYPRLAND_INSTANCE_SIGNATURE");
             const char* xdgRuntimeDir = getenv("XDG_RUNTIME_DIR");
@@ -102,14 +128,14 @@ namespace Workspaces
             }
 
             // First try $XDG_RUNTIME_DIR/hypr/.../. This is the new dir.
-            std::string socketPath = std::string(xdgRuntimeDir) + "/hypr/" + instanceSignature + "/.socket.sock";
+            std::string socketPath = std::string(xdgRuntimeDir) + "/hypr/" + instanceSignature + "/" + socketName;
             if (std::filesystem::exists(socketPath))
             {
                 return socketPath;
             }
 
             // Next try /tmp/hypr/.../. This is removed as of https://github.com/hyprwm/Hyprland/pull/5788
-            socketPath = "/tmp/hypr/" + std::string(instanceSignature) + "/.socket.sock";
+            socketPath = "/tmp/hypr/" + std::string(instanceSignature) + "/" + socketName;
             if (std::filesystem::exists(socketPath))
             {
                 return socketPath;
@@ -117,19 +143,20 @@ namespace Workspaces
             return "";
         }
 
-        std::string DispatchIPC(const std::string& arg)
+        // Returns the connected socket or -1
+        static int ConnectSocket(const char* socketName)
         {
-            int hyprSocket = socket(AF_UNIX, SOCK_STREAM, 0);
-            std::string socketPath = GetSocketPath();
+            std::string socketPath = GetSocketPath(socketName);
             if (socketPath == "")
             {
-                LOG("Error: Couldn't find the Hyprland socket!");
-                return "";
+                LOG("Error: Couldn't find the Hyprland socket " << socketName << "!");
+                return -1;
             }
+            int hyprSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
 
             sockaddr_un addr = {};
             addr.sun_family = AF_UNIX;
-            memcpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path));
+            memcpy(addr.sun_path, socketPath.c_str(), std::min(socketPath.size(), sizeof(addr.sun_path) - 1));
 
             int ret = Utils::RetrySocketOp(
                 [&]()
@@ -139,7 +166,18 @@ namespace Workspaces
                 5, "connect");
             if (ret < 0)
             {
-                LOG("Error: Couldn't connect to Hyprland socket.");
+                LOG("Error: Couldn't connect to Hyprland socket " << socketName << ".");
+                close(hyprSocket);
+                return -1;
+            }
+            return hyprSocket;
+        }
+
+        std::string DispatchIPC(const std::string& arg)
+        {
+            int hyprSocket = ConnectSocket(".socket.sock");
+            if (hyprSocket < 0)
+            {
                 return "";
             }
 
@@ -152,6 +190,7 @@ namespace Workspaces
             if (written < 0)
             {
                 LOG("Error: Couldn't write to Hyprland socket.");
+                close(hyprSocket);
                 return "";
             }
             char buf[2056];
@@ -172,6 +211,7 @@ namespace Workspaces
                 if (bytesRead < 0)
                 {
                     LOG("Error: Couldn't read from Hyprland socket.");
+                    close(hyprSocket);
                     return "";
                 }
                 res += std::string(buf, bytesRead);
@@ -180,23 +220,40 @@ namespace Workspaces
             return res;
         }
 
+        // Model of Hyprland's workspaces. Filled by Resync() and then kept up to date by the events of .socket2.sock
+        // Workspace id -> monitor name
+        static std::unordered_map<int32_t, std::string> workspaceMonitors;
+        // Monitor name -> active workspace id
+        static std::unordered_map<std::string, int32_t> activeWorkspaces;
+        static std::string focusedMonitor;
+
         static std::vector<System::WorkspaceStatus> workspaceStati;
         static uint32_t maxUsedWorkspace = 0;
 
-        void PollStatus(const std::string& monitor, uint32_t numWorkspaces)
-        {
-            if (RuntimeConfig::Get().hasWorkspaces == false)
-            {
-                LOG("Error: Polled workspace status, but Workspaces isn't open!");
-                return;
-            }
-            workspaceStati.clear();
-            workspaceStati.resize(numWorkspaces, System::WorkspaceStatus::Dead);
-            maxUsedWorkspace = 0;
+        static int eventSocket = -1;
+        static guint eventSource = 0;
+        static std::string eventBuffer;
+        // Reconnecting to .socket2.sock backs off exponentially, e.g. while Hyprland isn't running (anymore)
+        constexpr guint minReconnectDelayMS = 1000;
+        constexpr guint maxReconnectDelayMS = 60 * 1000;
+        static guint reconnectSource = 0;
+        static guint reconnectDelayMS = minReconnectDelayMS;
+        // Only log the first failed attempt of a row
+        static bool reconnectFailureLogged = false;
+        // While there is no event socket, the model is rebuilt on this interval instead
+        constexpr guint fallbackResyncMS = 1000;
+        static guint fallbackResyncSource = 0;
+        static std::function<void()> onChange;
 
+        // A fresh copy of the model, built by a resync
+        using Model = HyprlandReply::Model;
+
+        // Parses the replies of the text IPC
+        static void ParseText(const std::string& workspaces, const std::string& monitors, Model& model)
+        {
             size_t parseIdx = 0;
             // First parse workspaces
-            std::string workspaces = DispatchIPC("/workspaces");
+            // Format: workspace ID <id> (<name>) on monitor <monitor>:
             while ((parseIdx = workspaces.find("workspace ID ", parseIdx)) != std::string::npos)
             {
                 // Advance two spaces
@@ -206,19 +263,21 @@ namespace Workspaces
 
                 std::string ws = workspaces.substr(begWSNum, endWSNum - begWSNum);
                 int32_t wsId = std::atoi(ws.c_str());
-                if (wsId >= 1 && wsId <= (int32_t)numWorkspaces)
+
+                size_t begMon = workspaces.find("on monitor ", endWSNum);
+                size_t endLine = workspaces.find('\n', endWSNum);
+                std::string mon;
+                if (begMon != std::string::npos && begMon < endLine)
                 {
-                    // WS is at least inactive
-                    workspaceStati[wsId - 1] = System::WorkspaceStatus::Inactive;
+                    begMon += strlen("on monitor ");
+                    size_t endMon = workspaces.rfind(':', endLine);
+                    mon = workspaces.substr(begMon, endMon - begMon);
                 }
-                // Update maxUsedWorkspace
-                if (wsId > 0 && (uint32_t)wsId > maxUsedWorkspace)
-                    maxUsedWorkspace = wsId;
+                model.workspaceMonitors[wsId] = mon;
                 parseIdx = endWSNum;
             }
 
             // Parse active workspaces for monitor
-            std::string monitors = DispatchIPC("/monitors");
             parseIdx = 0;
             while ((parseIdx = monitors.find("Monitor ", parseIdx)) != std::string::npos)
             {
@@ -243,11 +302,614 @@ namespace Workspaces
                 size_t endFocused = monitors.find('\n', begFocused);
                 bool focused = std::string_view(monitors).substr(begFocused, endFocused - begFocused) == "yes";
 
+                model.activeWorkspaces[mon] = wsId;
+                if (focused)
+                {
+                    model.focusedMonitor = mon;
+                }
+            }
+        }
+
+        // Runs on the worker pool, so it may only touch its own model
+        static Model FetchModel()
+        {
+            Model model;
+            if (HyprlandReply::ParseJSON(DispatchIPC("[[BATCH]]j/workspaces;j/monitors"), model))
+            {
+                return model;
+            }
+
+            LOG("Hyprland: Couldn't parse JSON reply, falling back to text IPC");
+            model = {};
+            ParseText(DispatchIPC("/workspaces"), DispatchIPC("/monitors"), model);
+            return model;
+        }
+
+        // The requests wait for Hyprland, so resyncing runs on the worker pool. Only one runs at a time, requests in the meantime
+        // start another one afterwards. Events, that arrive while it runs, may be newer than the reply, so they're applied again on top.
+        static bool resyncInFlight = false;
+        static bool resyncRequested = false;
+        static std::vector<std::string> eventsDuringResync;
+
+        static bool HandleEvent(std::string_view line);
+
+        static void Resync();
+        static void FinishResync(Model&& model)
+        {
+            if (!resyncInFlight)
+            {
+                // Shut down in the meantime
+                return;
+            }
+            workspaceMonitors = std::move(model.workspaceMonitors);
+            activeWorkspaces = std::move(model.activeWorkspaces);
+            focusedMonitor = std::move(model.focusedMonitor);
+            for (auto& line : eventsDuringResync)
+            {
+                HandleEvent(line);
+            }
+            eventsDuringResync.clear();
+            resyncInFlight = false;
+
+            if (resyncRequested)
+            {
+                resyncRequested = false;
+                Resync();
+            }
+            if (onChange)
+            {
+                onChange();
+            }
+        }
+
+        // Rebuilds the model from scratch. onChange is called, once the new model is in place.
+        static void Resync()
+        {
+            if (resyncInFlight)
+            {
+                resyncRequested = true;
+                return;
+            }
+            resyncInFlight = true;
+            bool submitted = WorkerPool::Submit((uintptr_t)&resyncInFlight,
+                                                []()
+                                                {
+                                                    PostToMain(
+                                                        [model = FetchModel()]() mutable
+                                                        {
+                                                            FinishResync(std::move(model));
+                                                        });
+                                                });
+            if (!submitted)
+            {
+                LOG("Hyprland: Couldn't queue a resync");
+                resyncInFlight = false;
+            }
+        }
+
+        // Returns 0 for named and special workspaces, which we never display.
+        static int32_t ParseWorkspaceId(std::string_view str)
+        {
+            int32_t id = 0;
+            auto res = std::from_chars(str.data(), str.data() + str.size(), id);
+            if (res.ec != std::errc() || res.ptr != str.data() + str.size())
+            {
+                return 0;
+            }
+            return id;
+        }
+
+        // Splits "a,b,c" into its fields. Missing fields are empty. The last field takes the rest, since names may contain commas.
+        template<size_t N>
+        static std::array<std::string_view, N> SplitEventData(std::string_view data)
+        {
+            std::array<std::string_view, N> fields;
+            for (size_t i = 0; i < N - 1; i++)
+            {
+                size_t comma = data.find(',');
+                fields[i] = data.substr(0, comma);
+                data = comma == std::string_view::npos ? std::string_view() : data.substr(comma + 1);
+            }
+            fields[N - 1] = data;
+            return fields;
+        }
+
+        static void SetActiveWorkspace(const std::string& monitor, int32_t wsId)
+        {
+            activeWorkspaces[monitor] = wsId;
+            if (wsId != 0)
+            {
+                workspaceMonitors[wsId] = monitor;
+            }
+        }
+
+        // Handles a single line of .socket2.sock (Format: EVENT>>DATA).
+        // The v1 events carry workspace names, the v2 events carry ids. Hyprland sends both, with the v2 event last.
+        // Numeric names are the same as the id, so handling both is fine and also supports older Hyprland versions, which only send v1.
+        // Returns whether the model changed.
+        static bool HandleEvent(std::string_view line)
+        {
+            size_t sep = line.find(">>");
+            if (sep == std::string_view::npos)
+            {
+                return false;
+            }
+            std::string_view event = line.substr(0, sep);
+            std::string_view data = line.substr(sep + 2);
+
+            if (event == "workspace")
+            {
+                SetActiveWorkspace(focusedMonitor, ParseWorkspaceId(data));
+            }
+            else if (event == "workspacev2")
+            {
+                SetActiveWorkspace(focusedMonitor, ParseWorkspaceId(SplitEventData<2>(data)[0]));
+            }
+            else if (event == "focusedmon" || event == "focusedmonv2")
+            {
+                // focusedmon>>MON,WSNAME; focusedmonv2>>MON,WSID
+                auto [monitor, workspace] = SplitEventData<2>(data);
+                focusedMonitor = monitor;
+                SetActiveWorkspace(focusedMonitor, ParseWorkspaceId(workspace));
+            }
+            else if (event == "createworkspace" || event == "createworkspacev2")
+            {
+                int32_t wsId = ParseWorkspaceId(SplitEventData<2>(data)[0]);
+                if (wsId != 0 && workspaceMonitors.count(wsId) == 0)
+                {
+                    // The monitor isn't part of the event. New workspaces are created on the focused monitor, otherwise a move event follows.
+                    workspaceMonitors[wsId] = focusedMonitor;
+                }
+            }
+            else if (event == "destroyworkspace" || event == "destroyworkspacev2")
+            {
+                workspaceMonitors.erase(ParseWorkspaceId(SplitEventData<2>(data)[0]));
+            }
+            else if (event == "moveworkspace")
+            {
+                // moveworkspace>>WSNAME,MON
+                auto [workspace, monitor] = SplitEventData<2>(data);
+                int32_t wsId = ParseWorkspaceId(workspace);
+                if (wsId != 0)
+                {
+                    workspaceMonitors[wsId] = monitor;
+                }
+            }
+            else if (event == "moveworkspacev2")
+            {
+                // moveworkspacev2>>WSID,WSNAME,MON
+                auto [workspace, name, monitor] = SplitEventData<3>(data);
+                int32_t wsId = ParseWorkspaceId(workspace);
+                if (wsId != 0)
+                {
+                    workspaceMonitors[wsId] = monitor;
+                }
+            }
+            else if (event == "monitoradded" || event == "monitorremoved" || event == "monitoraddedv2" || event == "monitorremovedv2")
+            {
+                // Workspaces get moved around, without us getting an event for each of them
+                Resync();
+            }
+            else
+            {
+                return false;
+            }
+            return true;
+        }
+
+        static void ConnectEvents();
+
+        static void StartFallbackResync()
+        {
+            if (fallbackResyncSource)
+            {
+                return;
+            }
+            fallbackResyncSource = g_timeout_add(
+                fallbackResyncMS,
+                [](gpointer) -> gboolean
+                {
+                    // Hyprland isn't running (anymore), don't log a failed request every time
+                    if (GetSocketPath(".socket.sock").empty())
+                    {
+                        return G_SOURCE_CONTINUE;
+                    }
+                    Resync();
+                    return G_SOURCE_CONTINUE;
+                },
+                nullptr);
+        }
+
+        static void StopFallbackResync()
+        {
+            if (fallbackResyncSource)
+            {
+                g_source_remove(fallbackResyncSource);
+                fallbackResyncSource = 0;
+            }
+        }
+
+        // Also keeps the widget updating until the event socket is back
+        static void ScheduleReconnect()
+        {
+            StartFallbackResync();
+            if (reconnectSource)
+            {
+                return;
+            }
+            reconnectSource = g_timeout_add(
+                reconnectDelayMS,
+                [](gpointer) -> gboolean
+                {
+                    reconnectSource = 0;
+                    ConnectEvents();
+                    return G_SOURCE_REMOVE;
+                },
+                nullptr);
+            reconnectDelayMS = std::min(reconnectDelayMS * 2, maxReconnectDelayMS);
+        }
+
+        // Doesn't block the main thread: A unix socket either connects right away, or fails (ECONNREFUSED if nobody listens, EAGAIN if
+        // the backlog is full). Both are retried later instead of in place. Returns the non-blocking socket or -1.
+        static int ConnectSocketNonBlocking(const char* socketName)
+        {
+            std::string socketPath = GetSocketPath(socketName);
+            if (socketPath == "")
+            {
+                errno = ENOENT;
+                return -1;
+            }
+            int hyprSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+            if (hyprSocket < 0)
+            {
+                return -1;
+            }
+
+            sockaddr_un addr = {};
+            addr.sun_family = AF_UNIX;
+            memcpy(addr.sun_path, socketPath.c_str(), std::min(socketPath.size(), sizeof(addr.sun_path) - 1));
+            int ret;
+            do
+            {
+                ret = connect(hyprSocket, (sockaddr*)&addr, SUN_LEN(&addr));
+            } while (ret < 0 && errno == EINTR);
+            if (ret < 0)
+            {
+                int err = errno;
+                close(hyprSocket);
+                errno = err;
+                return -1;
+            }
+            return hyprSocket;
+        }
+
+        static gboolean OnEvents(gint fd, GIOCondition condition, gpointer)
+        {
+            bool changed = false;
+            bool disconnected = condition & (G_IO_HUP | G_IO_ERR);
+            char buf[4096];
+            while (!disconnected)
+            {
+                ssize_t bytesRead = read(fd, buf, sizeof(buf));
+                if (bytesRead < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                {
+                    break;
+                }
+                if (bytesRead <= 0)
+                {
+                    disconnected = true;
+                    break;
+                }
+                eventBuffer.append(buf, bytesRead);
+            }
+
+            // Handle all complete lines. An incomplete one stays in the buffer, until the rest arrives.
+            std::string_view events = eventBuffer;
+            size_t endLine;
+            while ((endLine = events.find('\n')) != std::string_view::npos)
+            {
+                if (resyncInFlight)
+                {
+                    eventsDuringResync.emplace_back(events.substr(0, endLine));
+                }
+                changed |= HandleEvent(events.substr(0, endLine));
+                events.remove_prefix(endLine + 1);
+            }
+            eventBuffer.erase(0, eventBuffer.size() - events.size());
+
+            if (disconnected)
+            {
+                LOG("Hyprland: Event socket disconnected, reconnecting");
+                close(eventSocket);
+                eventSocket = -1;
+                eventSource = 0;
+                eventBuffer.clear();
+                ScheduleReconnect();
+            }
+
+            // A burst of events (e.g. switching monitors) only results in a single update
+            if (changed && onChange)
+            {
+                onChange();
+            }
+            return disconnected ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
+        }
+
+        static void ConnectEvents()
+        {
+            if (eventSocket >= 0 || reconnectSource)
+            {
+                return;
+            }
+            eventSocket = ConnectSocketNonBlocking(".socket2.sock");
+            if (eventSocket < 0)
+            {
+                if (!reconnectFailureLogged)
+                {
+                    LOG("Hyprland: Couldn't connect to the event socket (" << strerror(errno) << "), retrying in the background");
+                    reconnectFailureLogged = true;
+                }
+                // Until then, the model is resynced on a timer
+                ScheduleReconnect();
+                return;
+            }
+            reconnectDelayMS = minReconnectDelayMS;
+            reconnectFailureLogged = false;
+            StopFallbackResync();
+            eventSource = g_unix_fd_add(eventSocket, (GIOCondition)(G_IO_IN | G_IO_HUP | G_IO_ERR), OnEvents, nullptr);
+            LOG("Hyprland: Listening for events");
+
+            // Events, that happened before we connected are lost, so get the full state once.
+            Resync();
+        }
+
+        bool SetOnChange(std::function<void()>&& callback)
+        {
+            if (RuntimeConfig::Get().hasWorkspaces == false)
+            {
+                return false;
+            }
+            onChange = std::move(callback);
+            ConnectEvents();
+            return true;
+        }
+
+        // A dispatch, that is sent without blocking the main thread
+        struct PendingDispatch
+        {
+            int fd;
+            std::string request;
+            size_t written = 0;
+            std::string reply;
+            std::function<void()> onFinish;
+        };
+
+        static void FinishDispatch(PendingDispatch* dispatch)
+        {
+            if (dispatch->reply != "ok")
+            {
+                LOG("Hyprland: \"" << dispatch->request << "\" failed: " << dispatch->reply);
+            }
+            close(dispatch->fd);
+            if (dispatch->onFinish)
+            {
+                dispatch->onFinish();
+            }
+            delete dispatch;
+        }
+
+        static gboolean OnDispatchReadable(gint fd, GIOCondition, gpointer data)
+        {
+            PendingDispatch* dispatch = (PendingDispatch*)data;
+            char buf[256];
+            while (true)
+            {
+                ssize_t bytesRead = read(fd, buf, sizeof(buf));
+                if (bytesRead < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                {
+                    return G_SOURCE_CONTINUE;
+                }
+                if (bytesRead <= 0)
+                {
+                    // Hyprland closes the connection after the reply
+                    FinishDispatch(dispatch);
+                    return G_SOURCE_REMOVE;
+                }
+                dispatch->reply.append(buf, bytesRead);
+            }
+        }
+
+        static gboolean OnDispatchWritable(gint fd, GIOCondition condition, gpointer data)
+        {
+            PendingDispatch* dispatch = (PendingDispatch*)data;
+            while (dispatch->written < dispatch->request.size() && !(condition & (G_IO_HUP | G_IO_ERR)))
+            {
+                ssize_t written = write(fd, dispatch->request.data() + dispatch->written, dispatch->request.size() - dispatch->written);
+                if (written < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                {
+                    return G_SOURCE_CONTINUE;
+                }
+                if (written < 0)
+                {
+                    break;
+                }
+                dispatch->written += written;
+            }
+            if (dispatch->written < dispatch->request.size())
+            {
+                dispatch->reply = "Couldn't write to Hyprland socket";
+                FinishDispatch(dispatch);
+                return G_SOURCE_REMOVE;
+            }
+            g_unix_fd_add(fd, (GIOCondition)(G_IO_IN | G_IO_HUP | G_IO_ERR), OnDispatchReadable, dispatch);
+            return G_SOURCE_REMOVE;
+        }
+
+        // Sends "dispatch <command>" without waiting for the reply. onFinish is called on the main thread, once Hyprland replied.
+        static void DispatchAsync(const std::string& command, std::function<void()>&& onFinish = {})
+        {
+            LOG("Hyprland: dispatch " << command);
+            int hyprSocket = ConnectSocket(".socket.sock");
+            if (hyprSocket < 0)
+            {
+                if (onFinish)
+                {
+                    onFinish();
+                }
+                return;
+            }
+            fcntl(hyprSocket, F_SETFL, fcntl(hyprSocket, F_GETFL) | O_NONBLOCK);
+
+            PendingDispatch* dispatch = new PendingDispatch();
+            dispatch->fd = hyprSocket;
+            dispatch->request = "dispatch " + command;
+            dispatch->onFinish = std::move(onFinish);
+            // The request is tiny, so this usually finishes the write right away
+            if (OnDispatchWritable(hyprSocket, G_IO_OUT, dispatch) == G_SOURCE_CONTINUE)
+            {
+                g_unix_fd_add(hyprSocket, (GIOCondition)(G_IO_OUT | G_IO_HUP | G_IO_ERR), OnDispatchWritable, dispatch);
+            }
+        }
+
+        // Moves the focus in the model to the workspace, so the bar shows the switch before Hyprland confirms it.
+        // The events that follow the dispatch correct the model, if the guess was wrong.
+        static void PredictGoto(int32_t wsId)
+        {
+            if (eventSocket < 0 || wsId <= 0)
+            {
+                return;
+            }
+            auto wsIt = workspaceMonitors.find(wsId);
+            if (wsIt != workspaceMonitors.end() && !wsIt->second.empty())
+            {
+                // Existing workspaces are focused on their monitor
+                focusedMonitor = wsIt->second;
+            }
+            SetActiveWorkspace(focusedMonitor, wsId);
+            if (onChange)
+            {
+                onChange();
+            }
+        }
+
+        // Predicts the target of "e+N"/"m+N": The Nth next existing workspace (on the focused monitor for m)
+        static int32_t PredictRelative(char scrollOp, int32_t steps)
+        {
+            auto activeIt = activeWorkspaces.find(focusedMonitor);
+            if (activeIt == activeWorkspaces.end())
+            {
+                return 0;
+            }
+            std::vector<int32_t> candidates;
+            for (auto& [wsId, wsMonitor] : workspaceMonitors)
+            {
+                if (wsId > 0 && (scrollOp == 'e' || wsMonitor == focusedMonitor))
+                {
+                    candidates.push_back(wsId);
+                }
+            }
+            std::sort(candidates.begin(), candidates.end());
+            auto curIt = std::find(candidates.begin(), candidates.end(), activeIt->second);
+            if (curIt == candidates.end())
+            {
+                return 0;
+            }
+            int32_t numCandidates = candidates.size();
+            int32_t target = ((curIt - candidates.begin() + steps) % numCandidates + numCandidates) % numCandidates;
+            return candidates[target];
+        }
+
+        // Scroll ticks, that haven't been sent yet. They're sent as a single relative dispatch, once the previous one finished.
+        static int32_t pendingScroll = 0;
+        static bool scrollInFlight = false;
+        static bool scrollFlushScheduled = false;
+
+        static void FlushScroll()
+        {
+            if (scrollInFlight || pendingScroll == 0)
+            {
+                return;
+            }
+            char scrollOp = Config::Get().workspaceScrollOnMonitor ? 'm' : 'e';
+            int32_t steps = pendingScroll;
+            pendingScroll = 0;
+
+            PredictGoto(PredictRelative(scrollOp, steps));
+
+            std::string relative = steps > 0 ? "+" + std::to_string(steps) : std::to_string(steps);
+            scrollInFlight = true;
+            DispatchAsync(std::string("workspace ") + scrollOp + relative,
+                          []()
+                          {
+                              scrollInFlight = false;
+                              FlushScroll();
+                          });
+        }
+
+        void Goto(uint32_t workspace)
+        {
+            PredictGoto(workspace);
+            DispatchAsync("workspace " + std::to_string(workspace));
+        }
+
+        void GotoNext(char direction)
+        {
+            pendingScroll += direction == '+' ? 1 : -1;
+            if (scrollFlushScheduled)
+            {
+                return;
+            }
+            // Wait until all queued scroll events have been handled
+            scrollFlushScheduled = true;
+            g_idle_add(
+                [](gpointer) -> gboolean
+                {
+                    scrollFlushScheduled = false;
+                    FlushScroll();
+                    return G_SOURCE_REMOVE;
+                },
+                nullptr);
+        }
+
+        void PollStatus(const std::string& monitor, uint32_t numWorkspaces)
+        {
+            if (RuntimeConfig::Get().hasWorkspaces == false)
+            {
+                LOG("Error: Polled workspace status, but Workspaces isn't open!");
+                return;
+            }
+            workspaceStati.assign(numWorkspaces, System::WorkspaceStatus::Dead);
+            maxUsedWorkspace = 0;
+            for (auto& [wsId, wsMonitor] : workspaceMonitors)
+            {
+                if (wsId >= 1 && wsId <= (int32_t)numWorkspaces)
+                {
+                    // WS is at least inactive
+                    workspaceStati[wsId - 1] = System::WorkspaceStatus::Inactive;
+                }
+                // Update maxUsedWorkspace
+                if (wsId > 0 && (uint32_t)wsId > maxUsedWorkspace)
+                    maxUsedWorkspace = wsId;
+            }
+            for (auto& [mon, wsId] : activeWorkspaces)
+            {
                 if (wsId >= 1 && wsId <= (int32_t)numWorkspaces)
                 {
                     if (mon == monitor)
                     {
-                        if (focused)
+                        if (mon == focusedMonitor)
                         {
                             workspaceStati[wsId - 1] = System::WorkspaceStatus::Active;
                         }
@@ -267,6 +929,31 @@ namespace Workspaces
             }
         }
 
+        void Shutdown()
+        {
+            StopFallbackResync();
+            // A resync, that is still running, is dropped once it finishes
+            resyncInFlight = false;
+            resyncRequested = false;
+            eventsDuringResync.clear();
+            if (reconnectSource)
+            {
+                g_source_remove(reconnectSource);
+                reconnectSource = 0;
+            }
+            if (eventSource)
+            {
+                g_source_remove(eventSource);
+                eventSource = 0;
+            }
+            if (eventSocket >= 0)
+            {
+                close(eventSocket);
+                eventSocket = -1;
+            }
+            onChange = nullptr;
+        }
+
         System::WorkspaceStatus GetStatus(uint32_t workspaceId)
         {
             if (RuntimeConfig::Get().hasWorkspaces == false)
@@ -330,6 +1017,63 @@ namespace Workspaces
         return Wayland::GetMaxUsedWorkspace();
     }
 
-    void Shutdown() {}
+    void Goto(uint32_t workspace)
+    {
+        if (RuntimeConfig::Get().hasWorkspaces == false)
+        {
+            LOG("Error: Called Go to workspace, but Workspaces isn't open!");
+            return;
+        }
+#ifdef WITH_HYPRLAND
+        if (Config::Get().useHyprlandIPC)
+        {
+            Hyprland::Goto(workspace);
+            return;
+        }
+#endif
+        // TODO: Use ext_workspaces for this, if applicable
+        LOG("Switching workspace: hyprctl dispatch workspace " << workspace);
+        Process::Run({"hyprctl", "dispatch", "workspace", std::to_string(workspace)});
+    }
+
+    void GotoNext(char direction)
+    {
+#ifdef WITH_HYPRLAND
+        if (Config::Get().useHyprlandIPC)
+        {
+            Hyprland::GotoNext(direction);
+            return;
+        }
+#endif
+        char scrollOp = 'e';
+        if (Config::Get().workspaceScrollOnMonitor)
+        {
+            scrollOp = 'm';
+        }
+        std::string target = std::string() + scrollOp + direction + "1";
+        LOG("Switching workspace: hyprctl dispatch workspace " << target);
+        Process::Run({"hyprctl", "dispatch", "workspace", target});
+    }
+
+    bool SetOnChange(std::function<void()>&& onChange)
+    {
+#ifdef WITH_HYPRLAND
+        if (Config::Get().useHyprlandIPC)
+        {
+            return Hyprland::SetOnChange(std::move(onChange));
+        }
+#endif
+        return Wayland::SetOnChange(std::move(onChange));
+    }
+
+    void Shutdown()
+    {
+#ifdef WITH_HYPRLAND
+        if (Config::Get().useHyprlandIPC)
+        {
+            Hyprland::Shutdown();
+        }
+#endif
+    }
 }
 #endif
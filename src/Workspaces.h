@@ -4,6 +4,7 @@
 #include "Config.h"
 
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <cstdlib>
 
@@ -22,31 +23,17 @@ namespace Workspaces
 
     uint32_t GetMaxUsedWorkspace();
 
+    // onChange is called on the main thread, whenever the workspaces changed. PollStatus is then cheap.
+    // Returns false, if the backend can't notify about changes and needs to be polled instead.
+    bool SetOnChange(std::function<void()>&& onChange);
+
     void Shutdown();
 
-    // TODO: Use ext_workspaces for this, if applicable
-    inline void Goto(uint32_t workspace)
-    {
-        if (RuntimeConfig::Get().hasWorkspaces == false)
-        {
-            LOG("Error: Called Go to workspace, but Workspaces isn't open!");
-            return;
-        }
-        LOG("Switching workspace: hyprctl dispatch workspace " << workspace);
-        system(("hyprctl dispatch workspace " + std::to_string(workspace)).c_str());
-    }
+    // Doesn't block. The status is updated right away, before the compositor confirms the switch.
+    void Goto(uint32_t workspace);
 
     // direction: + or -
-    inline void GotoNext(char direction)
-    {
-        char scrollOp = 'e';
-        if (Config::Get().workspaceScrollOnMonitor)
-        {
-            scrollOp = 'm';
-        }
-        std::string cmd = std::string("hyprctl dispatch workspace ") + scrollOp + direction + "1";
-        LOG("Switching workspace: " << cmd.c_str());
-        system(cmd.c_str());
-    }
+    // Ticks in quick succession are combined into a single switch.
+    void GotoNext(char direction);
 }
 #endif
@@ -4,15 +4,22 @@
 #include "Bar.h"
 #include "AudioFlyin.h"
 #include "BluetoothDevices.h"
+#include "Mixer.h"
+#include "Popup.h"
+#include "Control.h"
+#include "CSS.h"
 #include "Plugin.h"
 #include "Config.h"
+#include "Wayland.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <unistd.h>
 
 const char* audioTmpFilePath = "/tmp/gBar__audio";
 const char* bluetoothTmpFilePath = "/tmp/gBar__bluetooth";
+const char* mixerTmpFilePath = "/tmp/gBar__mixer";
 
 static bool tmpFileOpen = false;
 
@@ -39,6 +46,7 @@ void CloseTmpFiles(int sig)
     {
         remove(audioTmpFilePath);
         remove(bluetoothTmpFilePath);
+        remove(mixerTmpFilePath);
     }
     if (sig != 0)
         exit(1);
@@ -58,6 +66,7 @@ void PrintHelp()
         "\tgBar bar DP-1 \tOpens the status bar on monitor \"DP-1\"\n"
         "\tgBar bar 0    \tOpens the status bar on monitor 0 (Legacy)\n"
         "\tgBar audio    \tOpens the audio flyin on the current monitor\n"
+        "\tgBar msg audio\tOpens the audio flyin of the running bars\n"
         "\n"
         "All options:\n"
         "\t--help/-h      \tPrints this help page and exits afterwards\n"
@@ -69,7 +78,103 @@ void PrintHelp()
         "\taudio          \tAn audio volume slider flyin\n"
         "\tmic            \tA microphone volume slider flyin\n"
         "\tbluetooth      \tA bluetooth connection widget\n"
-        "\t[plugin]       \tTries to open and run the plugin lib[plugin].so\n");
+        "\tmixer          \tA mixer for output/input devices and applications\n"
+        "\t[plugin]       \tTries to open and run the plugin lib[plugin].so\n"
+        "\n"
+        "Controlling a running bar:\n"
+        "\tgBar msg [--monitor MONITOR] COMMAND [ARGS...]\n"
+        "\t               \tWithout --monitor, popups open on the focused monitor and everything else is sent to all running bars\n"
+        "\taudio/mic      \tOpens the audio/microphone flyin\n"
+        "\tbluetooth      \tOpens the bluetooth widget\n"
+        "\tmixer          \tOpens the mixer\n"
+        "\tset-text NAME TEXT\tSets the text of the Text:NAME widget\n"
+        "\tset-value NAME VALUE\tSets the Sensor:NAME widget to VALUE (0-1)\n"
+        "\tresample       \tSamples all sensors right away\n"
+        "\treload-css     \tLoads the style again\n"
+        "\treload-config  \tLoads the config again and recreates the bar\n");
+}
+
+// Without --monitor, these only go to the bar on the focused monitor. Otherwise every bar would open its own popup.
+static bool IsPopupCommand(std::string_view command)
+{
+    return command == "audio" || command == "mic" || command == "mixer" || command == "bluetooth";
+}
+
+int SendMessage(int argc, char** argv)
+{
+    std::string monitor;
+    std::string request;
+    for (int i = 0; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (request.empty() && (arg == "-m" || arg == "--monitor"))
+        {
+            ASSERT(i + 1 < argc, "Not enough arguments provided for -m/--monitor!");
+            monitor = argv[i + 1];
+            i += 1;
+            continue;
+        }
+        // Requests are line based
+        std::replace(arg.begin(), arg.end(), '\n', ' ');
+        if (!request.empty())
+            request += ' ';
+        request += arg;
+    }
+    if (request.empty())
+    {
+        LOG("Error: No command specified!\n");
+        PrintHelp();
+        return 1;
+    }
+    if (monitor.empty() && IsPopupCommand(std::string_view(request).substr(0, request.find(' '))))
+        return Control::SendToFocused(request);
+    return Control::Send(monitor, request);
+}
+
+void AddControlCommands(Window& window)
+{
+    auto addPopup = [&window](const std::string& name, Popup::Type type)
+    {
+        Control::AddCommand(name,
+                            [&window, type](std::string_view) -> std::string
+                            {
+                                Popup::Open(type, window.GetName());
+                                return "";
+                            });
+    };
+    addPopup("audio", Popup::Type::Audio);
+    addPopup("mic", Popup::Type::Mic);
+    addPopup("mixer", Popup::Type::Mixer);
+#ifdef WITH_BLUEZ
+    if (RuntimeConfig::Get().hasBlueZ)
+        addPopup("bluetooth", Popup::Type::Bluetooth);
+#endif
+
+    Control::AddCommand(std::string(Control::focusedCommand),
+                        [&window](std::string_view) -> std::string
+                        {
+                            return Wayland::GetFocusedMonitor() == window.GetName() ? "" : "not focused";
+                        });
+    Control::AddCommand("resample",
+                        [](std::string_view) -> std::string
+                        {
+                            System::ResampleSensors();
+                            return "";
+                        });
+    Control::AddCommand("reload-css",
+                        [](std::string_view) -> std::string
+                        {
+                            return CSS::Reload() ? "" : "no style could be loaded";
+                        });
+    Control::AddCommand("reload-config",
+                        [&window](std::string_view) -> std::string
+                        {
+                            // Destroys the open popups right away (and drops their queued closes), so none of them outlives the reload
+                            Popup::CloseAll();
+                            System::ReloadConfig();
+                            window.Recreate();
+                            return "";
+                        });
 }
 
 void CreateWidget(const std::string& widget, Window& window)
@@ -86,6 +191,22 @@ void CreateWidget(const std::string& widget, Window& window)
     {
         OpenAudioFlyin(window, window.GetName(), AudioFlyin::Type::Microphone);
     }
+    else if (widget == "mixer")
+    {
+        if (access(mixerTmpFilePath, F_OK) != 0)
+        {
+            tmpFileOpen = true;
+            FILE* mixerTmpFile = fopen(mixerTmpFilePath, "w");
+            Mixer::Create(window, window.GetName());
+            fclose(mixerTmpFile);
+        }
+        else
+        {
+            // Already open, close
+            LOG("Mixer already open (/tmp/gBar__mixer exists)! Exiting...");
+            exit(0);
+        }
+    }
 #ifdef WITH_BLUEZ
     else if (widget == "bluetooth")
     {
@@ -120,6 +241,12 @@ void CreateWidget(const std::string& widget, Window& window)
 
 int main(int argc, char** argv)
 {
+    if (argc >= 2 && std::string(argv[1]) == "msg")
+    {
+        // Client only, nothing is initialized
+        return SendMessage(argc - 2, argv + 2);
+    }
+
     std::string widget;
     int32_t monitor = -1;
     std::string monitorName;
@@ -203,8 +330,16 @@ int main(int argc, char** argv)
     {
         CreateWidget(widget, window);
     };
+    if (widget == "bar")
+    {
+        AddControlCommands(window);
+        Control::Start(window.GetName());
+    }
     window.Run();
 
+    Control::Shutdown();
+    // Popups of the bar unregister their System callbacks on destruction
+    Popup::CloseAll();
     System::FreeResources();
     CloseTmpFiles(0);
     return 0;